@@ -11,6 +11,7 @@ Battery::Battery()
    percentage = 100;
    burnCount = 0;
    burnRate = 20;
+   fiveWarning = false;
 }
 
 
@@ -90,6 +91,54 @@ void Battery::depleteBattery()
 
 }
 
+/**
+ * Depletes the battery as if depleteBattery() was called once per second for the given
+ * number of seconds, in constant time. The burn rate must not change during that time.
+ *
+ * @param seconds is the number of seconds to deplete the battery for
+ */
+void Battery::advance(qint64 seconds)
+{
+    if(seconds <= 0){ return; }
+
+    //Not enough seconds to reach the next step, only count them
+    qint64 firstStep = secondsUntilNextStep();
+    if(seconds < firstStep){
+        burnCount += (int)seconds;
+        return;
+    }
+
+    //After the first step the battery loses 1% every burnRate seconds
+    qint64 afterFirstStep = seconds - firstStep;
+    qint64 steps = 1 + afterFirstStep / burnRate;
+    burnCount = (int)(afterFirstStep % burnRate);
+    percentage = steps >= percentage ? 0 : percentage - (int)steps;
+}
+
+/**
+ * Number of seconds until depleteBattery() takes off the next percentage.
+ * The burn count can already be at or above a lowered burn rate, then it happens on the next second.
+ *
+ * @return the number of seconds, at least 1
+ */
+int Battery::secondsUntilNextStep()
+{
+    return burnCount + 1 >= burnRate ? 1 : burnRate - burnCount;
+}
+
+/**
+ * Number of seconds until the battery percentage drops to target at the current burn rate
+ *
+ * @param target is the percentage to reach
+ * @return the number of seconds, -1 if the battery is already at or below target
+ */
+qint64 Battery::secondsUntilPercentage(int target)
+{
+    if(target < 0 || percentage <= target){ return -1; }
+
+    return secondsUntilNextStep() + (qint64)(percentage - target - 1) * burnRate;
+}
+
 /**
  * Setter for the battery percentage
  * @param choice is the new perecentage to set it to
@@ -107,3 +156,27 @@ void Battery::setFiveWarning(bool choice){ fiveWarning = choice; }
  * @return true or false
  */
 bool Battery::getFiveWarning(){ return fiveWarning; }
+
+/**
+ * Get the number of seconds it takes to burn a percentage off the battery
+ * @return the burn rate in seconds
+ */
+int Battery::getBurnRate(){ return burnRate; }
+
+/**
+ * Get the number of seconds since the last percentage was burnt off the battery
+ * @return the burn count in seconds
+ */
+int Battery::getBurnCount(){ return burnCount; }
+
+/**
+ * Set the number of seconds it takes to burn a percentage off the battery, to restore a snapshot
+ * @param seconds is the burn rate in seconds
+ */
+void Battery::setBurnRate(int seconds){ burnRate = seconds; }
+
+/**
+ * Set the number of seconds since the last percentage was burnt off the battery, to restore a snapshot
+ * @param seconds is the burn count in seconds
+ */
+void Battery::setBurnCount(int seconds){ burnCount = seconds; }
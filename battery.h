@@ -1,6 +1,8 @@
 #ifndef BATTERY_H
 #define BATTERY_H
 
+#include <QtGlobal>
+
 /*
 Class: Battery
 
@@ -8,7 +10,8 @@ Purpose: This class represents the battery for the ces device
 
 Usage: - Keeps track of the battery percent for the device
        - Can increase/decrease the rate at which battery is used up
-       - Depletes battery percentage
+       - Depletes battery percentage, one second at a time or over any number of seconds at once
+       - Computes how many seconds are left until the next 1% step or until a given percentage
        - Keeps track of when to warn user about 5% and 2% battery levels
        - Has getters/setters for percentage and fiveWarning
 */
@@ -26,12 +29,19 @@ public:
     void defaultBurnRate();         //Set the battery burn rate back to the default setting
     void intialTherapyBurnRate();   //Set the battery burn rate when therapy starts
     void depleteBattery();          //Decreases the battery percent left using the burn rate
+    void advance(qint64 seconds);   //Same as depleting the battery once per second for the given seconds
+    int secondsUntilNextStep();     //Seconds until the battery percentage drops by the next 1%
+    qint64 secondsUntilPercentage(int target);  //Seconds until the battery percentage drops to target, -1 if it already is
 
     //Getter/setters
     int getBatteryPercentage();             //Returns the percentage
     void setBatteryPercentage(int choice);  //Sets the battery perecentage to the specified choice. Only used for admin area
     void setFiveWarning(bool choice);       //Set to true when battery reaches 5% left
     bool getFiveWarning();                  //Get whether the five warning has already been displayed
+    int getBurnRate();                      //Returns the number of seconds it takes to burn a percentage
+    int getBurnCount();                     //Returns the number of seconds since the last percentage was burnt
+    void setBurnRate(int seconds);          //Sets the number of seconds it takes to burn a percentage. Only used to restore a snapshot
+    void setBurnCount(int seconds);         //Sets the number of seconds since the last percentage was burnt. Only used to restore a snapshot
 
 private:
     int burnCount;                  //Counts the number of seconds since the last battery percentage depletion
@@ -0,0 +1,10 @@
+# Every benchmark of the CES device simulation, built on its own (not part of ces-device.pro).
+# Each one links the core sources (ces-core.pri) with QtCore only.
+
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    devicebench \
+    formatbench \
+    querybench \
+    waveformbench
@@ -0,0 +1,17 @@
+# Benchmark of the hot paths of the CES device.
+# Times each path on its own, on a real time and a virtual time scheduler, and writes the results as JSON.
+
+QT       -= gui
+QT       += core
+
+CONFIG += c++11 console release
+CONFIG -= app_bundle
+
+TARGET = devicebench
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(../../ces-core.pri)
+
+SOURCES += \
+    main.cpp
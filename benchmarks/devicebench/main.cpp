@@ -0,0 +1,351 @@
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QStringList>
+#include <QTextStream>
+#include <algorithm>
+#include <vector>
+
+#include "cesdevice.h"
+#include "deviceobserver.h"
+#include "recordstore.h"
+#include "scheduler.h"
+
+/*
+Class: BenchObserver
+
+Purpose: Observes the device of a benchmark
+
+Usage: Counts the notifications it gets, so every notification is a real virtual call
+       that does a little work, like the widgets or the headless runner would.
+*/
+
+class BenchObserver : public DeviceObserver
+{
+public:
+    BenchObserver() : notifications(0) {}
+
+    void timerDisplayChanged(const QString& text) override { notifications += text.size(); }
+    void recordSaved(const SessionRecord& record) override { notifications += record.id & 1; }
+    void treatingChanged(bool) override { notifications++; }
+    void sessionEnded() override { notifications++; }
+
+    qint64 getNotifications() { return notifications; }
+
+private:
+    qint64 notifications;   //Notifications received (weighted, only keeps the calls from being optimized away)
+};
+
+
+/*
+Class: BenchDevice
+
+Purpose: A device with its own clock, observer and record store, as the GUI sets it up
+
+Usage: Made fresh for every measured path, so no path sees the state another one left.
+       The device starts on, like a new CESDevice.
+       The record store is a file in the temporary folder, removed when the device is deleted.
+*/
+
+class BenchDevice
+{
+public:
+    BenchDevice(Scheduler::Mode mode, const QString& path)
+        : scheduler(mode), store(path), device(&scheduler, &observer), path(path)
+    {
+        //Same record start times on every run
+        scheduler.setEpoch(1577836800);
+
+        QFile::remove(path);
+        store.open();
+        device.setRecordStore(&store);
+    }
+
+    ~BenchDevice()
+    {
+        store.close();
+        QFile::remove(path);
+    }
+
+    Scheduler scheduler;        //Clock of the device
+    BenchObserver observer;     //Receives the notifications of the device
+    RecordStore store;          //Keeps the recorded sessions
+    CESDevice device;           //The device measured
+
+private:
+    QString path;               //File of the record store
+};
+
+
+//Calls timed together by the paths that take tens of ns, a single call would mostly time the timer
+static const int BATCH = 100;
+
+
+/*
+Struct: Result
+
+Purpose: Time of every call (or batch of calls) of one measured path on one clock
+*/
+
+struct Result
+{
+    const char* name;               //Measured path
+    const char* clock;              //"real" or "virtual"
+    int batch;                      //Calls per sample, their mean is the sample
+    std::vector<qint64> samples;    //Time of a call in ns, one per call or batch of calls
+};
+
+
+/**
+ * Nanoseconds at a percentile of sorted samples
+ *
+ * @param sorted is the samples in increasing order
+ * @param percentile is 0 - 100
+ * @return the sample at the percentile
+ */
+static qint64 percentile(const std::vector<qint64>& sorted, double percentile)
+{
+    if(sorted.empty()){ return 0; }
+
+    size_t index = (size_t)(percentile / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+
+/**
+ * TherapySession::timerTimeout() -> CESDevice::updateDisplay(): one second of a running therapy.
+ * The session is made long enough that it never runs out while it is measured. Timed in batches.
+ */
+static void benchTick(Result& result, Scheduler::Mode mode, int iterations, const QString& path)
+{
+    BenchDevice bench(mode, path);
+    bench.device.changeSkinContact(true);
+
+    TherapySession* session = bench.device.getCurrSession();
+    session->setDuration(iterations + 1);
+
+    result.batch = BATCH;
+    QElapsedTimer wallTime;
+    for(int i = 0; i < iterations; i += BATCH){
+        wallTime.start();
+        for(int call = 0; call < BATCH; call++){
+            session->timerTimeout();
+        }
+        result.samples.push_back(wallTime.nsecsElapsed() / BATCH);
+    }
+}
+
+/**
+ * CESDevice::batteryUpdate(), what the battery timer runs: depleting the battery up to the clock,
+ * checking the percentage and scheduling the next step. On a virtual clock every call comes one
+ * second later (the clock is moved in the batch, which costs a store). A real time clock can't be
+ * moved, every call reads it and depletes what passed. Timed in batches, the battery is recharged
+ * between them before it gets near the 5% warning.
+ */
+static void benchBattery(Result& result, Scheduler::Mode mode, int iterations, const QString& path)
+{
+    BenchDevice bench(mode, path);
+    bool virtualTime = mode == Scheduler::VirtualTime;
+
+    result.batch = BATCH;
+    QElapsedTimer wallTime;
+    for(int i = 0; i < iterations; i += BATCH){
+        if(bench.device.getBattery()->getBatteryPercentage() < 20){
+            bench.device.changeBatteryPercentage(100);
+        }
+
+        wallTime.start();
+        for(int call = 0; call < BATCH; call++){
+            if(virtualTime){
+                bench.scheduler.advanceTo(bench.scheduler.now() + 1000);
+            }
+            bench.device.batteryUpdate();
+        }
+        result.samples.push_back(wallTime.nsecsElapsed() / BATCH);
+    }
+}
+
+/**
+ * CESDevice::saveRecording(): making a record of the current session and appending it to the store.
+ * Timed in batches.
+ */
+static void benchSaveRecording(Result& result, Scheduler::Mode mode, int iterations, const QString& path)
+{
+    BenchDevice bench(mode, path);
+    bench.device.changeSkinContact(true);
+
+    result.batch = BATCH;
+    QElapsedTimer wallTime;
+    for(int i = 0; i < iterations; i += BATCH){
+        wallTime.start();
+        for(int call = 0; call < BATCH; call++){
+            bench.device.saveRecording((i + call) % 60);
+        }
+        result.samples.push_back(wallTime.nsecsElapsed() / BATCH);
+    }
+}
+
+/**
+ * CESDevice::stopSession() with recording on: the record, the notifications and stopping the therapy
+ * timer. A new recorded session is started outside the timing before every call.
+ */
+static void benchStopSession(Result& result, Scheduler::Mode mode, int iterations, const QString& path)
+{
+    BenchDevice bench(mode, path);
+
+    QElapsedTimer wallTime;
+    for(int i = 0; i < iterations; i++){
+        bench.device.setRecording(true);
+        bench.device.changeSkinContact(true);
+
+        wallTime.start();
+        bench.device.stopSession(5);
+        result.samples.push_back(wallTime.nsecsElapsed());
+
+        bench.device.changeSkinContact(false);
+    }
+}
+
+/**
+ * A whole use of the device: power on, record, treat until the therapy runs out, then power off.
+ * The countdown follows the clock, so the clock has to get to its end: a virtual clock jumps from
+ * deadline to deadline, a real time clock runs as fast as possible while the event loop is pumped.
+ */
+static void benchCycle(Result& result, Scheduler::Mode mode, int iterations, const QString& path)
+{
+    BenchDevice bench(mode, path);
+    if(mode == Scheduler::RealTime){
+        bench.scheduler.setSpeed(Scheduler::MAX_SPEED);
+    }
+
+    //A new device starts on
+    bench.device.pressPower();
+
+    QElapsedTimer wallTime;
+    for(int i = 0; i < iterations; i++){
+        wallTime.start();
+
+        bench.device.pressPower();
+        bench.device.setRecording(true);
+        bench.device.changeSkinContact(true);
+        while(bench.device.getIsTreating()){
+            if(mode == Scheduler::RealTime){
+                QCoreApplication::processEvents();
+            }else{
+                bench.scheduler.runNext();
+            }
+        }
+        bench.device.pressPower();
+
+        result.samples.push_back(wallTime.nsecsElapsed());
+
+        //Keep the battery from running flat over many cycles
+        bench.device.changeBatteryPercentage(100);
+    }
+}
+
+
+/**
+ * Writes the results as JSON: for each path and clock, the calls per second and the
+ * mean, minimum, percentiles and maximum time of a call in ns. For a path timed in batches
+ * the percentiles are those of the batch means.
+ *
+ * @param out is the stream to write to
+ * @param results is the measured paths
+ */
+static void writeJson(QTextStream& out, std::vector<Result>& results)
+{
+    out << "{\n  \"benchmark\": \"devicebench\",\n  \"results\": [\n";
+
+    for(size_t i = 0; i < results.size(); i++){
+        std::vector<qint64>& samples = results[i].samples;
+        std::sort(samples.begin(), samples.end());
+
+        qint64 total = 0;
+        for(qint64 sample : samples){ total += sample; }
+        double mean = samples.empty() ? 0.0 : (double)total / samples.size();
+
+        out << "    {\"name\": \"" << results[i].name << "\", \"clock\": \"" << results[i].clock
+            << "\", \"iterations\": " << (qint64)samples.size() * results[i].batch
+            << ", \"batch\": " << results[i].batch
+            << ", \"ops_per_sec\": " << (total > 0 ? samples.size() * 1e9 / total : 0.0)
+            << ", \"ns\": {\"mean\": " << mean
+            << ", \"min\": " << percentile(samples, 0)
+            << ", \"p50\": " << percentile(samples, 50)
+            << ", \"p90\": " << percentile(samples, 90)
+            << ", \"p99\": " << percentile(samples, 99)
+            << ", \"p999\": " << percentile(samples, 99.9)
+            << ", \"max\": " << percentile(samples, 100) << "}}"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+
+    out << "  ]\n}\n";
+}
+
+
+/**
+ * Times the hot paths of the device one at a time, on a real time and on a virtual time
+ * scheduler, and writes the results as JSON to stdout (or --output).
+ * Each path is called --iterations times (100000 by default, full cycles a tenth of that).
+ * --clock real or --clock virtual only measures one clock.
+ *
+ * Usage: devicebench [--iterations N] [--clock real|virtual] [--output FILE]
+ */
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    int iterations = 100000;
+    QString clock;
+    QString output;
+
+    QStringList args = a.arguments();
+    for(int i = 1; i < args.size() - 1; i++){
+        if(args[i] == "--iterations"){ iterations = args[i + 1].toInt(); }
+        if(args[i] == "--clock"){ clock = args[i + 1]; }
+        if(args[i] == "--output"){ output = args[i + 1]; }
+    }
+    if(iterations <= 0){ return 0; }
+
+    typedef void (*Bench)(Result&, Scheduler::Mode, int, const QString&);
+    struct Path { const char* name; Bench bench; int iterations; };
+    const Path paths[] = {
+        { "timerTimeout", benchTick, iterations },
+        { "batteryUpdate", benchBattery, iterations },
+        { "saveRecording", benchSaveRecording, iterations },
+        { "stopSession", benchStopSession, iterations },
+        { "cycle", benchCycle, iterations / 10 > 0 ? iterations / 10 : 1 }
+    };
+
+    QString path = QDir::temp().filePath("devicebench.log");
+    std::vector<Result> results;
+
+    for(int real = 0; real < 2; real++){
+        const char* clockName = real ? "real" : "virtual";
+        if(!clock.isEmpty() && clock != clockName){ continue; }
+
+        for(const Path& bench : paths){
+            Result result;
+            result.name = bench.name;
+            result.clock = clockName;
+            result.batch = 1;
+            result.samples.reserve(bench.iterations);
+
+            bench.bench(result, real ? Scheduler::RealTime : Scheduler::VirtualTime, bench.iterations, path);
+            results.push_back(result);
+        }
+    }
+
+    if(output.isEmpty()){
+        QTextStream out(stdout);
+        writeJson(out, results);
+        return 0;
+    }
+
+    QFile file(output);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)){ return 1; }
+    QTextStream out(&file);
+    writeJson(out, results);
+    return 0;
+}
@@ -0,0 +1,17 @@
+# Benchmark of the record formatter.
+# Formats a large synthetic history with the formatter and with the QDateTime/QString code it replaced.
+
+QT       -= gui
+QT       += core
+
+CONFIG += c++11 console release
+CONFIG -= app_bundle
+
+TARGET = formatbench
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(../../ces-core.pri)
+
+SOURCES += \
+    main.cpp
@@ -0,0 +1,141 @@
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QTextStream>
+#include <cstring>
+#include <vector>
+
+#include "recordformatter.h"
+#include "sessionrecord.h"
+
+/**
+ * The text of a record as the records tab built it before the RecordFormatter:
+ * a QDateTime conversion, a locale lookup and a QString allocation per piece.
+ *
+ * @param record is the record to write
+ * @return the text of the record
+ */
+static QString formatWithQString(const SessionRecord& record)
+{
+    //Convert the epoch time startTime into a readable format
+    const QDateTime dt = QDateTime::fromTime_t((uint)record.startTime);
+    const QString textdate = dt.toString( Qt::DefaultLocaleShortDate );
+    QString tempString = QString("[");
+    tempString += textdate;
+    tempString += QString("]");
+
+    //Insert the ID into the string
+    tempString += "\nID: " + QString::number(record.id);
+
+    //Set the duration of the time into mm:ss format
+    tempString += ", Duration: " + QString::number(record.duration) + ":00";
+
+    //Set the waveform of the string
+    switch(record.waveform)
+    {
+    case 0:
+        tempString += QString(", Waveform: Alpha");
+        break;
+    case 1:
+        tempString += QString(", Waveform: Betta");
+        break;
+    case 2:
+        tempString += QString(", Waveform: Gamma");
+        break;
+    default:
+        break;
+    }
+
+    //Set the Frequency of the string, shortened to Freq
+    switch(record.frequency)
+    {
+    case 0:
+        tempString += QString(", Freq: 0.5Hz");
+        break;
+    case 1:
+        tempString += QString(", Freq: 77Hz");
+        break;
+    case 2:
+        tempString += QString(", Freq: 100Hz");
+        break;
+    default:
+        break;
+    }
+
+    //Set the powerlevel
+    tempString += ", Powerlevel: " + QString::number(record.powerLevel);
+    return tempString;
+}
+
+
+/**
+ * Formats --records records (1 million by default), one every 7 minutes since January 1st 2020,
+ * with the old QString code and with the RecordFormatter, checks every text is the same and
+ * reports the time of both.
+ */
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    int records = 1000000;
+    QStringList args = a.arguments();
+    for(int i = 1; i < args.size() - 1; i++){
+        if(args[i] == "--records"){ records = args[i + 1].toInt(); }
+    }
+
+    const qint64 january2020 = 1577836800;
+
+    std::vector<SessionRecord> history(records);
+    for(int i = 0; i < records; i++){
+        SessionRecord& record = history[i];
+        memset(&record, 0, sizeof(record));
+        record.startTime = january2020 + (qint64)i * 420 + i % 60;
+        record.id = (quint32)i;
+        record.duration = (quint16)(20 * (1 + i % 3));
+        record.waveform = (quint8)(i % 3);
+        record.frequency = (quint8)((i / 3) % 3);
+        record.powerLevel = (quint8)(i % 11);
+    }
+
+    QTextStream out(stdout);
+
+    //Old path, the length of every text is summed so the work can't be skipped
+    QElapsedTimer wallTime;
+    wallTime.start();
+    qint64 oldBytes = 0;
+    for(const SessionRecord& record : history){
+        oldBytes += formatWithQString(record).size();
+    }
+    qint64 oldElapsed = wallTime.nsecsElapsed();
+
+    //Formatter writing into its own buffer, as the records tab uses it
+    RecordFormatter formatter;
+    wallTime.restart();
+    qint64 newBytes = 0;
+    for(const SessionRecord& record : history){
+        int length;
+        formatter.format(record, &length);
+        newBytes += length;
+    }
+    qint64 newElapsed = wallTime.nsecsElapsed();
+
+    //Same text for every record
+    int mismatches = 0;
+    for(const SessionRecord& record : history){
+        if(formatter.toString(record) != formatWithQString(record)){
+            if(mismatches++ == 0){
+                out << "first mismatch: " << formatter.toString(record) << " / " << formatWithQString(record) << "\n";
+            }
+        }
+    }
+
+    out << "records: " << records << ", mismatches: " << mismatches << "\n"
+        << "QString: ms: " << oldElapsed / 1000000.0 << ", ns/record: " << (double)oldElapsed / records
+        << ", bytes: " << oldBytes << "\n"
+        << "RecordFormatter: ms: " << newElapsed / 1000000.0 << ", ns/record: " << (double)newElapsed / records
+        << ", bytes: " << newBytes << "\n"
+        << "speedup: " << (newElapsed > 0 ? (double)oldElapsed / newElapsed : 0.0) << "x\n";
+
+    return mismatches == 0 ? 0 : 1;
+}
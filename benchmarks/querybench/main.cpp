@@ -0,0 +1,125 @@
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QStringList>
+#include <QTextStream>
+#include <cstring>
+#include <random>
+
+#include "recordindex.h"
+#include "recordstore.h"
+
+/**
+ * Times a query on the index and checks its result against a scan of every record
+ *
+ * @param name is the name of the query in the report
+ * @param query is the query to run
+ * @param index is the index to query
+ * @param store is the store the index is built on
+ * @return true if the index found as many records as the scan
+ */
+static bool timeQuery(const char* name, const RecordQuery& query, RecordIndex& index, RecordStore& store)
+{
+    QElapsedTimer wallTime;
+    wallTime.start();
+    qint64 found = (qint64)index.find(query).size();
+    qint64 elapsed = wallTime.nsecsElapsed();
+
+    qint64 scanned = 0;
+    for(qint64 i = 0; i < store.count(); i++){
+        scanned += query.matches(store.at(i)) ? 1 : 0;
+    }
+
+    QTextStream out(stdout);
+    out << name << ": found " << found << (found == scanned ? "" : " (MISMATCH)")
+        << ", us: " << elapsed / 1000.0 << "\n";
+    return found == scanned;
+}
+
+
+/**
+ * Builds a history of --records records (10 million by default), one every minute since
+ * January 1st 2020, in --path (querybench.log by default), then times a few queries on it.
+ * Exits with 1 if the index gives a different result than a scan for any of them.
+ */
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    qint64 records = 10000000;
+    QString path = "querybench.log";
+
+    QStringList args = a.arguments();
+    for(int i = 1; i < args.size() - 1; i++){
+        if(args[i] == "--records"){ records = args[i + 1].toInt(); }
+        if(args[i] == "--path"){ path = args[i + 1]; }
+    }
+
+    const qint64 january2020 = 1577836800;
+    const qint64 march2020 = 1583020800;
+    const qint64 april2020 = 1585699200;
+
+    //Synthetic history: mostly full 20/40/60 minute sessions, some cut short
+    QFile::remove(path);
+    {
+        RecordLog log(path);
+        if(!log.open()){ return 1; }
+
+        std::mt19937 random(1);
+        const int durations[] = { 20, 40, 60 };
+        SessionRecord record;
+        memset(&record, 0, sizeof(record));
+
+        for(qint64 i = 0; i < records; i++){
+            record.startTime = january2020 + i * 60;
+            record.id = (quint32)i;
+            record.duration = random() % 10 == 0 ? random() % 61 : durations[random() % 3];
+            record.waveform = random() % 3;
+            record.frequency = random() % 3;
+            record.powerLevel = random() % 11;
+            log.append(record);
+        }
+    }
+
+    RecordStore store(path);
+    if(!store.open()){ return 1; }
+    RecordIndex index(&store);
+
+    QElapsedTimer wallTime;
+    wallTime.start();
+    index.update();
+
+    QTextStream out(stdout);
+    out << "records: " << store.count() << ", index build ms: " << wallTime.elapsed() << "\n";
+
+    int mismatches = 0;
+
+    RecordQuery gammaMarch;
+    gammaMarch.from = march2020;
+    gammaMarch.to = april2020;
+    gammaMarch.waveform = 2;
+    gammaMarch.frequency = 1;
+    gammaMarch.minDuration = 41;
+    mismatches += !timeQuery("77Hz Gamma in March 2020 over 40 minutes", gammaMarch, index, store);
+
+    RecordQuery powerMarch;
+    powerMarch.from = march2020;
+    powerMarch.to = april2020;
+    powerMarch.minPowerLevel = 3;
+    powerMarch.maxPowerLevel = 3;
+    mismatches += !timeQuery("150uA in March 2020", powerMarch, index, store);
+
+    RecordQuery shortSessions;
+    shortSessions.minDuration = 5;
+    shortSessions.maxDuration = 7;
+    mismatches += !timeQuery("5 to 7 minutes, any time", shortSessions, index, store);
+
+    RecordQuery alphaFull;
+    alphaFull.waveform = 0;
+    alphaFull.frequency = 2;
+    alphaFull.minPowerLevel = 10;
+    mismatches += !timeQuery("100Hz Alpha at 500uA, any time", alphaFull, index, store);
+
+    out << "mismatches: " << mismatches << "\n";
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,17 @@
+# Benchmark of the record index.
+# Fills a record log with a large synthetic history and times queries on it.
+
+QT       -= gui
+QT       += core
+
+CONFIG += c++11 console release
+CONFIG -= app_bundle
+
+TARGET = querybench
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(../../ces-core.pri)
+
+SOURCES += \
+    main.cpp
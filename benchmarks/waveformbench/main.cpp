@@ -0,0 +1,285 @@
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QTextStream>
+#include <cmath>
+#include <vector>
+
+#include "waveformgenerator.h"
+#include "waveformkernels.h"
+
+/*
+Class: RuntimeSwitchGenerator
+
+Purpose: Reference generator for the benchmark, the SSE2 generator the specialized ones replaced
+
+Usage: Produces the same signal as WaveformGenerator with the same SSE2 kernels (square, corrected
+       parabola sine, triangle), but keeps the settings as they were set and switches on the waveform
+       and frequency for every block, with a floating point phase that is wrapped with a floor.
+*/
+
+class RuntimeSwitchGenerator
+{
+public:
+    RuntimeSwitchGenerator(int sampleRate) : sampleRate(sampleRate), waveform(0), frequency(0), amplitude(0), phase(0) {}
+
+    void configure(int waveform, int frequency, int powerLevel)
+    {
+        this->waveform = waveform;
+        this->frequency = frequency;
+        this->amplitude = powerLevel * 50.0f;
+    }
+
+    void generate(float* samples, int count)
+    {
+        for(int start = 0; start < count; start += BLOCK_SIZE){
+            int blockSize = count - start < BLOCK_SIZE ? count - start : BLOCK_SIZE;
+
+            double hz;
+            switch(frequency)
+            {
+            case 0: hz = 0.5; break;
+            case 1: hz = 77.0; break;
+            case 2: hz = 100.0; break;
+            default: hz = 0.0; break;
+            }
+            double increment = hz / sampleRate;
+
+            switch(waveform)
+            {
+            case 0: squareKernel(samples + start, blockSize, (float)phase, (float)increment, amplitude); break;
+            case 1: sineKernel(samples + start, blockSize, (float)phase, (float)increment, amplitude); break;
+            case 2: triangleKernel(samples + start, blockSize, (float)phase, (float)increment, amplitude); break;
+            default:
+                for(int i = 0; i < blockSize; i++){ samples[start + i] = 0.0f; }
+                break;
+            }
+
+            phase += blockSize * increment;
+            phase -= std::floor(phase);
+        }
+    }
+
+private:
+    static const int BLOCK_SIZE = 4096;     //Samples generated from one starting phase
+
+    int sampleRate;         //Samples per second
+    int waveform;           //Selected waveform (0 - 2)
+    int frequency;          //Selected frequency (0 - 2)
+    float amplitude;        //Peak current in uA
+    double phase;           //Position in the current period at the next sample, 0 - 1
+
+    static void squareKernel(float* samples, int count, float phase, float increment, float amplitude)
+    {
+        int i = 0;
+
+#ifdef __SSE2__
+        const __m128 lanes = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+        const __m128 step = _mm_set1_ps(increment);
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 positive = _mm_set1_ps(amplitude);
+        const __m128 sign = _mm_set1_ps(-0.0f);
+
+        for(; i + 4 <= count; i += 4){
+            __m128 p = _mm_add_ps(_mm_set1_ps(phase), _mm_mul_ps(_mm_add_ps(_mm_set1_ps((float)i), lanes), step));
+            p = _mm_sub_ps(p, _mm_cvtepi32_ps(_mm_cvttps_epi32(p)));
+            __m128 secondHalf = _mm_cmpge_ps(p, half);
+            _mm_storeu_ps(samples + i, _mm_xor_ps(positive, _mm_and_ps(secondHalf, sign)));
+        }
+#endif
+
+        for(; i < count; i++){
+            float p = phase + i * increment;
+            p -= (int)p;
+            samples[i] = p < 0.5f ? amplitude : -amplitude;
+        }
+    }
+
+    static void sineKernel(float* samples, int count, float phase, float increment, float amplitude)
+    {
+        int i = 0;
+
+#ifdef __SSE2__
+        const __m128 lanes = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+        const __m128 step = _mm_set1_ps(increment);
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 two = _mm_set1_ps(2.0f);
+        const __m128 four = _mm_set1_ps(4.0f);
+        const __m128 correction = _mm_set1_ps(0.225f);
+        const __m128 scale = _mm_set1_ps(amplitude);
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+        for(; i + 4 <= count; i += 4){
+            __m128 p = _mm_add_ps(_mm_set1_ps(phase), _mm_mul_ps(_mm_add_ps(_mm_set1_ps((float)i), lanes), step));
+            p = _mm_sub_ps(p, _mm_cvtepi32_ps(_mm_cvttps_epi32(p)));
+            __m128 t = _mm_sub_ps(_mm_mul_ps(two, p), one);
+            __m128 y = _mm_mul_ps(four, _mm_sub_ps(t, _mm_mul_ps(t, _mm_and_ps(t, absMask))));
+            y = _mm_add_ps(y, _mm_mul_ps(correction, _mm_sub_ps(_mm_mul_ps(y, _mm_and_ps(y, absMask)), y)));
+            _mm_storeu_ps(samples + i, _mm_mul_ps(_mm_sub_ps(_mm_setzero_ps(), y), scale));
+        }
+#endif
+
+        for(; i < count; i++){
+            float p = phase + i * increment;
+            p -= (int)p;
+            float t = 2.0f * p - 1.0f;
+            float y = 4.0f * (t - t * std::fabs(t));
+            y += 0.225f * (y * std::fabs(y) - y);
+            samples[i] = -y * amplitude;
+        }
+    }
+
+    static void triangleKernel(float* samples, int count, float phase, float increment, float amplitude)
+    {
+        int i = 0;
+
+#ifdef __SSE2__
+        const __m128 lanes = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+        const __m128 step = _mm_set1_ps(increment);
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 slope = _mm_set1_ps(-4.0f * amplitude);
+        const __m128 peak = _mm_set1_ps(amplitude);
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+        for(; i + 4 <= count; i += 4){
+            __m128 p = _mm_add_ps(_mm_set1_ps(phase), _mm_mul_ps(_mm_add_ps(_mm_set1_ps((float)i), lanes), step));
+            p = _mm_sub_ps(p, _mm_cvtepi32_ps(_mm_cvttps_epi32(p)));
+            __m128 distance = _mm_and_ps(_mm_sub_ps(p, half), absMask);
+            _mm_storeu_ps(samples + i, _mm_add_ps(peak, _mm_mul_ps(slope, distance)));
+        }
+#endif
+
+        for(; i < count; i++){
+            float p = phase + i * increment;
+            p -= (int)p;
+            samples[i] = amplitude * (1.0f - 4.0f * std::fabs(p - 0.5f));
+        }
+    }
+};
+
+
+/*
+Class: GenericGenerator
+
+Purpose: Reference generator for the benchmark, the fixed point kernels without the specialization
+
+Usage: Runs the generic kernel of the waveform (WaveformKernels::GENERIC_KERNELS), which takes the
+       phase step when it is called, the same way WaveformGenerator runs a specialized one.
+       The difference with the specialized generators is only the constant phase step.
+*/
+
+class GenericGenerator
+{
+public:
+    GenericGenerator(int sampleRate) : sampleRate(sampleRate), kernel(nullptr), amplitude(0), phase(0), phaseIncrement(0) {}
+
+    void configure(int waveform, int frequency, int powerLevel)
+    {
+        this->kernel = WaveformKernels::GENERIC_KERNELS[waveform];
+        this->phaseIncrement = WaveformKernels::phaseIncrement(frequency, sampleRate);
+        this->amplitude = powerLevel * 50.0f;
+    }
+
+    void generate(float* samples, int count)
+    {
+        quint32 laneIncrement = (quint32)((phaseIncrement + 0x80000000ull) >> 32);
+
+        for(int start = 0; start < count; start += BLOCK_SIZE){
+            int blockSize = count - start < BLOCK_SIZE ? count - start : BLOCK_SIZE;
+            kernel(samples + start, blockSize, (quint32)(phase >> 32), laneIncrement, amplitude);
+            phase += (quint64)blockSize * phaseIncrement;
+        }
+    }
+
+private:
+    static const int BLOCK_SIZE = 4096;     //Samples generated from one starting phase
+
+    int sampleRate;                 //Samples per second
+    WaveformKernels::Kernel kernel; //Generic generator of the waveform
+    float amplitude;                //Peak current in uA
+    quint64 phase;                  //Position in the current period (fixed point, 2^64 is a full period)
+    quint64 phaseIncrement;         //Part of a period between two samples
+};
+
+
+/**
+ * Generates the given number of samples with a generator, one block at a time
+ *
+ * @param generator is the generator to run, already configured
+ * @param block receives the samples
+ * @param total is the number of samples to generate
+ * @param checksum receives the sum of the samples, so the work can't be optimized away
+ * @return the wall clock time in nanoseconds
+ */
+template<typename Generator>
+static qint64 timeGenerator(Generator& generator, std::vector<float>& block, qint64 total, double& checksum)
+{
+    QElapsedTimer wallTime;
+    wallTime.start();
+
+    for(qint64 done = 0; done < total; done += (qint64)block.size()){
+        int count = total - done < (qint64)block.size() ? (int)(total - done) : (int)block.size();
+        generator.generate(block.data(), count);
+        checksum += block[count - 1];
+    }
+
+    return wallTime.nsecsElapsed();
+}
+
+
+/**
+ * Times the runtime switch, generic and specialized generators on each of the nine
+ * waveform/frequency combinations.
+ * --seconds sets the length of the signal of each combination (60 by default),
+ * --rate sets the number of samples per second (48000 by default, the specialized generators
+ * are only used at 48000).
+ */
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    int seconds = 60;
+    int sampleRate = 48000;
+
+    QStringList args = a.arguments();
+    for(int i = 1; i < args.size() - 1; i++){
+        if(args[i] == "--seconds"){ seconds = args[i + 1].toInt(); }
+        if(args[i] == "--rate"){ sampleRate = args[i + 1].toInt(); }
+    }
+    if(sampleRate < WaveformKernels::MIN_SAMPLE_RATE){ sampleRate = WaveformKernels::MIN_SAMPLE_RATE; }
+
+    const char* waveforms[] = { "Alpha", "Beta", "Gamma" };
+    const char* frequencies[] = { "0.5Hz", "77Hz", "100Hz" };
+
+    std::vector<float> block(65536);
+    qint64 total = (qint64)seconds * sampleRate;
+    double checksum = 0;
+    QTextStream out(stdout);
+
+    for(int waveform = 0; waveform < 3; waveform++){
+        for(int frequency = 0; frequency < 3; frequency++){
+
+            RuntimeSwitchGenerator reference(sampleRate);
+            reference.configure(waveform, frequency, 10);
+            qint64 referenceTime = timeGenerator(reference, block, total, checksum);
+
+            GenericGenerator generic(sampleRate);
+            generic.configure(waveform, frequency, 10);
+            qint64 genericTime = timeGenerator(generic, block, total, checksum);
+
+            WaveformGenerator specialized(sampleRate);
+            specialized.configure(waveform, frequency, 10);
+            qint64 specializedTime = timeGenerator(specialized, block, total, checksum);
+
+            out << waveforms[waveform] << " " << frequencies[frequency]
+                << ": runtime switch megasamples/s: " << (referenceTime > 0 ? total * 1e3 / referenceTime : 0.0)
+                << ", generic megasamples/s: " << (genericTime > 0 ? total * 1e3 / genericTime : 0.0)
+                << ", specialized megasamples/s: " << (specializedTime > 0 ? total * 1e3 / specializedTime : 0.0)
+                << ", speedup: " << (specializedTime > 0 ? (double)referenceTime / specializedTime : 0.0)
+                << ", over generic: " << (specializedTime > 0 ? (double)genericTime / specializedTime : 0.0) << "\n";
+        }
+    }
+
+    out << "checksum: " << checksum << "\n";
+    return 0;
+}
@@ -0,0 +1,18 @@
+# Benchmark of the waveform generators.
+# Compares the specialized generators of WaveformGenerator with the generic fixed point
+# kernels and with the SSE2 generator that switches on the waveform and frequency for every block.
+
+QT       -= gui
+QT       += core
+
+CONFIG += c++11 console release
+CONFIG -= app_bundle
+
+TARGET = waveformbench
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(../../ces-core.pri)
+
+SOURCES += \
+    main.cpp
@@ -0,0 +1,61 @@
+# Widget-free simulation core of the CES device.
+# Shared by the GUI (ces-device.pro) and the headless runner (headless/headless.pro),
+# it only needs QtCore.
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+SOURCES += \
+    $$PWD/cesdevice.cpp \
+    $$PWD/battery.cpp \
+    $$PWD/therapysession.cpp \
+    $$PWD/timer.cpp \
+    $$PWD/scheduler.cpp \
+    $$PWD/timingwheel.cpp \
+    $$PWD/fleet.cpp \
+    $$PWD/fleetrunner.cpp \
+    $$PWD/waveformgenerator.cpp \
+    $$PWD/outputthread.cpp \
+    $$PWD/recordlog.cpp \
+    $$PWD/recordstore.cpp \
+    $$PWD/recordindex.cpp \
+    $$PWD/usagerollups.cpp \
+    $$PWD/recordformatter.cpp \
+    $$PWD/displaytext.cpp \
+    $$PWD/latencyhistogram.cpp \
+    $$PWD/latencystats.cpp \
+    $$PWD/trace.cpp \
+    $$PWD/eventlog.cpp \
+    $$PWD/eventreplay.cpp \
+    $$PWD/devicesnapshot.cpp \
+    $$PWD/notificationqueue.cpp
+
+HEADERS += \
+    $$PWD/therapysession.h \
+    $$PWD/timer.h \
+    $$PWD/cesdevice.h \
+    $$PWD/battery.h \
+    $$PWD/deviceobserver.h \
+    $$PWD/scheduler.h \
+    $$PWD/timingwheel.h \
+    $$PWD/fleet.h \
+    $$PWD/fleetrunner.h \
+    $$PWD/waveformgenerator.h \
+    $$PWD/waveformkernels.h \
+    $$PWD/spscring.h \
+    $$PWD/outputsink.h \
+    $$PWD/outputthread.h \
+    $$PWD/sessionrecord.h \
+    $$PWD/recordlog.h \
+    $$PWD/recordstore.h \
+    $$PWD/recordindex.h \
+    $$PWD/usagerollups.h \
+    $$PWD/recordformatter.h \
+    $$PWD/displaytext.h \
+    $$PWD/latencyhistogram.h \
+    $$PWD/latencystats.h \
+    $$PWD/trace.h \
+    $$PWD/eventlog.h \
+    $$PWD/eventreplay.h \
+    $$PWD/devicesnapshot.h \
+    $$PWD/notificationqueue.h
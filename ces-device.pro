@@ -15,20 +15,16 @@ DEFINES += QT_DEPRECATED_WARNINGS
 # You can also select to disable deprecated APIs only up to a certain version of Qt.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+include(ces-core.pri)
+
 SOURCES += \
-    cesdevice.cpp \
-    battery.cpp \
     main.cpp \
     mainwindow.cpp \
-    therapysession.cpp \
-    timer.cpp
+    recordlistmodel.cpp
 
 HEADERS += \
     mainwindow.h \
-    therapysession.h \
-    timer.h \
-    cesdevice.h \
-    battery.h \
+    recordlistmodel.h
 
 FORMS += \
     mainwindow.ui
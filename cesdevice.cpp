@@ -1,17 +1,33 @@
 #include "cesdevice.h"
+#include "displaytext.h"
+#include "trace.h"
 
+#include <algorithm>
+#include <cstring>
+
+
+
+/**
+ * Used by devices that were created without an observer, nothing is reported
+ */
+static DeviceObserver noObserver;
 
 
 /**
  * The basic constructor for the CESDevice
  * Sets up the battery and Session objects.
  * Sets recording, treating, skin contact status to false by default
+ * Creates the battery, inactivity and skin contact timers and starts the first two
+ * since the device starts turned on
  *
- * @param display is used for displaying therapy time
- * @param recordList is used for showing recorded therapies
+ * @param scheduler is the clock the device's timers run on (real or virtual time)
+ * @param observer receives every change of the device, may be nullptr
  */
-CESDevice::CESDevice(QLCDNumber* display, QListWidget* recordList)
+CESDevice::CESDevice(Scheduler* scheduler, DeviceObserver* observer)
 {
+    this->scheduler = scheduler;
+    this->output = nullptr;
+    this->eventLog = nullptr;
     this->battery = new Battery();
     this->currentSession = new TherapySession(this);
 
@@ -20,23 +36,499 @@ CESDevice::CESDevice(QLCDNumber* display, QListWidget* recordList)
     this->isTreating = false;
     this->isRecording = false;
     this->isContactingSkin = false;
+    this->isDisabled = false;
 
-    this->timerDisplay =  display;
-    this->recordList = recordList;
+    this->observer = observer != nullptr ? observer : &noObserver;
 
     this->recordedSessionsIDs = 0;
+    this->recordStore = nullptr;
+    this->usageRollups = nullptr;
+    this->inactiveSeconds = 0;
+    this->inactiveSince = scheduler->now();
+
+    //Create timer used for depleting the battery, it only runs out when the next 1% is burnt
+    batteryTimer = new Timer(scheduler, [this]() { batteryUpdate(); });
+    batteryTimer->setSingleShot(true);
+
+    //Create timer used for turning the device off when it has been inactive too long
+    inactivityTimer = new Timer(scheduler, [this]() { inactivityTimeout(); });
+    inactivityTimer->setSingleShot(true);
+
+    //Create timer used for checking for loss of skin contact
+    skinOffTimer = new Timer(scheduler, [this]() { skinContactUpdate(); });
+    skinOffTimer->setSingleShot(true);
+
+    //All timers, in the order a snapshot keeps them
+    timers[DeviceSnapshot::TherapyTimer] = currentSession->getInternalClock();
+    timers[DeviceSnapshot::BatteryTimer] = batteryTimer;
+    timers[DeviceSnapshot::InactivityTimer] = inactivityTimer;
+    timers[DeviceSnapshot::SkinOffTimer] = skinOffTimer;
+
+    //Start battery and inactivity timers
+    batteryAnchor = scheduler->now();
+    scheduleBatteryStep();
+    scheduleInactivityOff();
 }
 
 /**
  * The basic deconstructor for the CESDevice
- * Delete the battery and therapy session
+ * Delete the battery, therapy session and timers
  */
 CESDevice::~CESDevice()
 {
+    delete this->batteryTimer;
+    delete this->inactivityTimer;
+    delete this->skinOffTimer;
     delete this->battery;
     delete this->currentSession;
 }
 
+/**
+ * Triggered when the power button is pressed.
+ * Turns the device off (ending and recording a running therapy) or turns it on
+ * if the battery is above 2% and the device is not disabled. If the earclips are
+ * already on the skin the therapy starts right away.
+ */
+void CESDevice::pressPower()
+{
+    TraceScope trace("pressPower", "input");
+    EventScope logged(eventLog, EventLog::PressPower);
+
+    //If device is on, turn it off
+    if(isOn){
+
+        //If session was in progress, end it. Will record it if that setting was chosen
+        if(isTreating){
+            stopSession(currentSession->getLastDuration() - currentSession->getDuration());
+            changeSkinContact(false);
+        }
+
+        //Turn off device and its timers
+        turnOff();
+        resetInactivity();
+
+    //Device is off and user is turning it on
+    }else{
+
+        //If battery percent is above 2 and the device is not disabled it can be turned on
+        if(battery->getBatteryPercentage() > 2 && !isDisabled){
+
+            setIsOn(true);
+            reportBattery();
+
+            //Start depleting the battery and timing inactivity
+            batteryAnchor = scheduler->now();
+            scheduleBatteryStep();
+            resetInactivity();
+
+            //If device is contacting skin, start therapy right away
+            if(isContactingSkin){
+
+                //Use duration that was selected last time device was on
+                currentSession->setDuration(currentSession->getLastDuration());
+                updateDisplay();
+
+                //Start the therapy at 100uA
+                currentSession->startSession();
+                observer->powerLevelChanged(currentSession->getLastPowerLevel());
+            }
+        }
+    }
+}
+
+/**
+ * Triggered when the record button is pressed. Turns recording on or off
+ */
+void CESDevice::toggleRecording()
+{
+    EventScope logged(eventLog, EventLog::ToggleRecording);
+
+    setRecording(!isRecording);
+}
+
+/**
+ * Triggered when the earclips touch or leave the skin.
+ * Touching the skin starts a new therapy (or resumes a paused one) if the device is on.
+ * Leaving the skin during a therapy pauses it and gives the user 5 seconds to reconnect.
+ *
+ * @param contact is true when the earclips are on the skin
+ */
+void CESDevice::changeSkinContact(bool contact)
+{
+    TraceScope trace("changeSkinContact", "input");
+    EventScope logged(eventLog, EventLog::SkinContact, contact ? 1 : 0);
+
+    setContact(contact);
+
+    //Skin contact is true
+    if(contact){
+
+        //Start treating if device is turned on
+        if(!isOn){ return; }
+
+        //If therapy was already in session and was paused by skin contact change to off,
+        //resume that session
+        if(isTreating){
+            currentSession->resumeSession();
+        }
+
+        //Start a new therapy
+        else{
+
+            //Reset inactivity timer to zero when treating
+            resetInactivity();
+
+            //Start the session and display intial therapy duration
+            currentSession->startSession();
+            updateDisplay();
+            observer->powerLevelChanged(currentSession->getLastPowerLevel());
+
+            //Set the battery burn rate to 1% every 18 seconds
+            syncBattery();
+            battery->intialTherapyBurnRate();
+            scheduleBatteryStep();
+        }
+
+    //Skin contact is changed to false
+    }else{
+
+        //If device was in a therapy session, pause it and
+        //start 5 second timeout
+        if(isTreating){
+            currentSession->pauseSession();
+            skinOffTimer->startTimer(5000);
+
+        //Otherwise device is not setup for treatment
+        }else{
+            setIsTreating(false);
+
+            syncBattery();
+            battery->defaultBurnRate();
+            scheduleBatteryStep();
+        }
+    }
+}
+
+/**
+ * Triggered when the device is disabled or re-enabled from the admin area
+ *
+ * @param enabled is false when the device is disabled
+ */
+void CESDevice::changeDeviceEnabled(bool enabled)
+{
+    TraceScope trace("changeDeviceEnabled", "input");
+    EventScope logged(eventLog, EventLog::DeviceEnabled, enabled ? 1 : 0);
+
+    //If changed to false
+    if(!enabled){
+
+        //If device was treating, end session. Record it if that was set
+        if(isTreating){
+            stopSession(currentSession->getLastDuration() - currentSession->getDuration());
+            changeSkinContact(false);
+        }
+
+        //Disable device, timers, and turn it off
+        setIsDisabled(true);
+        turnOff();
+
+    //Re-enabling device from admin area
+    }else{
+
+        //Reset the battery burn rate (not turning it on though), re-enable device
+        //set uA of device back to 100
+        syncBattery();
+        battery->defaultBurnRate();
+        scheduleBatteryStep();
+        setIsDisabled(false);
+        changePowerLevel(100);
+    }
+}
+
+/**
+ * Triggered when the power level uA is changed in the admin area
+ * Exceeding 700uA disables the device
+ *
+ * @param level is the new uA of the device
+ */
+void CESDevice::changePowerLevel(int level)
+{
+    TraceScope trace("changePowerLevel", "input");
+    EventScope logged(eventLog, EventLog::PowerLevel, (quint64)level);
+
+    //Increase/decrease power level between 0-500 uA
+    if(level <= 500){
+        currentSession->setLastPowerLevel(level / 50);
+        observer->powerLevelChanged(level / 50);
+        updateOutput();
+    }
+
+    //When maximum uA for device is exceeded
+    if(level > 700){
+        changeDeviceEnabled(false);
+    }
+}
+
+/**
+ * Triggered when the battery percentage is changed in the admin area
+ *
+ * @param percentage is the new percentage of the battery
+ */
+void CESDevice::changeBatteryPercentage(int percentage)
+{
+    TraceScope trace("changeBatteryPercentage", "input");
+    EventScope logged(eventLog, EventLog::BatteryPercentage, (quint64)percentage);
+
+    syncBattery();
+    battery->setBatteryPercentage(percentage);
+    reportBattery();
+
+    //Check the new percentage for warnings on the next second
+    if(isOn){
+        batteryTimer->startTimerAt(batteryAnchor + 1000);
+    }
+}
+
+/**
+ * Triggered by the battery timer whenever the next 1% of the battery is burnt.
+ * The seconds in between are depleted at once, the result is the same as depleting
+ * the battery every second. Warns at 5%. At 2% the device warns and shuts itself down.
+ */
+void CESDevice::batteryUpdate()
+{
+    TraceScope trace("batteryUpdate", "timer");
+
+    //If the device is off, the battery is not depleted
+    if(!isOn){ return; }
+
+    //Simulate battery depletion up to the current second
+    syncBattery();
+
+    int batteryPercentage = battery->getBatteryPercentage();
+    reportBattery();
+
+    //Warn once when the device is at 5% battery
+    if(batteryPercentage == 5 && !battery->getFiveWarning()){
+
+        observer->batteryWarning(5);
+        battery->setFiveWarning(true);
+
+    //Warn and turn off device if battery reaches 2%
+    }else if(batteryPercentage == 2){
+
+        observer->batteryWarning(2);
+
+        if(isTreating){
+            stopSession(currentSession->getLastDuration() - currentSession->getDuration());
+            changeSkinContact(false);
+        }
+
+        turnOff();
+
+    //Set the 5% warning to available again
+    }else if(batteryPercentage != 5){
+        battery->setFiveWarning(false);
+    }
+
+    //Wait for the next 1%
+    scheduleBatteryStep();
+}
+
+/**
+ * Triggered from the admin area: adds a minute of inactivity, which brings the time the device
+ * turns off a second closer. After 30 minutes the device turns off.
+ */
+void CESDevice::inactivityUpdate()
+{
+    TraceScope trace("inactivityUpdate", "input");
+    EventScope logged(eventLog, EventLog::InactivityUpdate);
+
+    //Inactivity is not counted while treating
+    if(isTreating){ return; }
+
+    inactiveSeconds += 60;
+    int seconds = getInactiveSeconds();
+    observer->inactivityChanged(seconds);
+
+    //If 30 minutes of inactivity reached, turn off device
+    if(seconds >= 1800 && isOn){
+        turnOff();
+    }else{
+        scheduleInactivityOff();
+    }
+}
+
+/**
+ * Called by the inactivity timer once the device has been inactive for 30 minutes, turns it off
+ */
+void CESDevice::inactivityTimeout()
+{
+    TraceScope trace("inactivityTimeout", "timer");
+
+    observer->inactivityChanged(getInactiveSeconds());
+    turnOff();
+}
+
+/**
+ * Called when 5 seconds elapses after losing contact with skin during a therapy session
+ */
+void CESDevice::skinContactUpdate()
+{
+    TraceScope trace("skinContactUpdate", "timer");
+
+    //If therapy is not running again when timer ends, stop the therapy and reset the device
+    if(!currentSession->getIsRunning()){
+
+        stopSession(currentSession->getLastDuration() - currentSession->getDuration());
+        setIsTreating(false);
+        resetSessionSettings();
+
+        syncBattery();
+        battery->defaultBurnRate();
+        scheduleBatteryStep();
+
+        observer->sessionEnded();
+    }
+}
+
+/**
+ * Set the inactive time back to zero
+ */
+void CESDevice::resetInactivity()
+{
+    EventScope logged(eventLog, EventLog::ResetInactivity);
+
+    //The count starts again from now, the device turns off 30 minutes after it
+    inactiveSeconds = 0;
+    if(inactiveSince >= 0){
+        inactiveSince = scheduler->now();
+        scheduleInactivityOff();
+    }
+
+    observer->inactivityChanged(inactiveSeconds);
+}
+
+/**
+ * Called by the therapy session once its timer ran out.
+ * Resets recording and power level, and removes the earclips for the next therapy.
+ */
+void CESDevice::finishSession()
+{
+    resetSessionSettings();
+    changeSkinContact(false);
+    observer->sessionEnded();
+}
+
+/**
+ * Turns off the device, stops its timers and recording
+ */
+void CESDevice::turnOff()
+{
+    //Burn the battery for the seconds the device was still on
+    syncBattery();
+
+    setIsOn(false);
+    setRecording(false);
+    batteryTimer->stopTimer();
+}
+
+/**
+ * Depletes the battery for the whole seconds that passed since it was last depleted.
+ * Only the device being on burns the battery.
+ */
+void CESDevice::syncBattery()
+{
+    if(!isOn){ return; }
+
+    qint64 seconds = (scheduler->now() - batteryAnchor) / 1000;
+    battery->advance(seconds);
+    batteryAnchor += seconds * 1000;
+}
+
+/**
+ * Sets the battery timer to the second at which the next 1% is burnt.
+ * Has to be called again whenever the burn rate changes.
+ */
+void CESDevice::scheduleBatteryStep()
+{
+    if(!isOn){ return; }
+
+    batteryTimer->startTimerAt(nextBatteryStepTime());
+}
+
+/**
+ * Counts inactivity from now when the device is on and not treating. Otherwise the count holds
+ * where it is and the inactivity timer stops, until the device is idle again.
+ */
+void CESDevice::countInactivity()
+{
+    bool counting = isOn && !isTreating;
+
+    if(counting && inactiveSince < 0){
+        inactiveSince = scheduler->now();
+        scheduleInactivityOff();
+    }else if(!counting && inactiveSince >= 0){
+        inactiveSeconds = getInactiveSeconds();
+        inactiveSince = -1;
+        scheduleInactivityOff();
+    }
+}
+
+/**
+ * Sets the inactivity timer to the time the count reaches 30 minutes (a minute for every
+ * second of the clock), or stops it while inactivity is not counted.
+ * Has to be called again whenever the count changes.
+ */
+void CESDevice::scheduleInactivityOff()
+{
+    if(inactiveSince < 0){
+        inactivityTimer->stopTimer();
+        return;
+    }
+
+    qint64 minutesLeft = (1800 - inactiveSeconds + 59) / 60;
+    inactivityTimer->startTimerAt(inactiveSince + (minutesLeft > 0 ? minutesLeft : 0) * 1000);
+}
+
+/**
+ * Sets recording off and the power level back to 100uA after a session
+ */
+void CESDevice::resetSessionSettings()
+{
+    setRecording(false);
+    currentSession->setLastPowerLevel(2);
+    observer->powerLevelChanged(2);
+    updateOutput();
+}
+
+/**
+ * Sends the settings of the current session to the output thread. Current only flows
+ * while the device is on and treating with the earclips on the skin.
+ */
+void CESDevice::updateOutput()
+{
+    if(output == nullptr){ return; }
+
+    OutputCommand command;
+    command.waveform = currentSession->getWaveform();
+    command.frequency = currentSession->getFrequency();
+    command.powerLevel = currentSession->getLastPowerLevel();
+    command.active = isOn && isTreating && isContactingSkin;
+    output->submit(command);
+}
+
+/**
+ * Reports the battery percentage to the observer, and to the event log so a replay can check it
+ */
+void CESDevice::reportBattery()
+{
+    if(eventLog != nullptr){
+        eventLog->note(EventLog::BatteryChanged, (quint64)battery->getBatteryPercentage());
+    }
+
+    observer->batteryChanged(battery->getBatteryPercentage());
+}
+
 /**
  * Increase the power of the current Therapy Session by 50mu
  * Increases the burn rate of the battery
@@ -44,13 +536,18 @@ CESDevice::~CESDevice()
  */
 void CESDevice::increasePower()
 {
+    EventScope logged(eventLog, EventLog::IncreasePower);
+
     int currentSessionPowerLevel = currentSession->getLastPowerLevel();
 
     this->currentSession->setLastPowerLevel(currentSessionPowerLevel == 10 ? 10 : currentSessionPowerLevel + 1);
 
+    syncBattery();
     this->battery->increaseBurnRate();
+    scheduleBatteryStep();
 
-
+    observer->powerLevelChanged(currentSession->getLastPowerLevel());
+    updateOutput();
 }
 
 /**
@@ -59,12 +556,18 @@ void CESDevice::increasePower()
  */
 void CESDevice::decreasePower()
 {
+    EventScope logged(eventLog, EventLog::DecreasePower);
 
     int currentSessionPowerLevel = currentSession->getLastPowerLevel();
 
     this->currentSession->setLastPowerLevel(currentSessionPowerLevel - 2 < 1 ? 1 : currentSessionPowerLevel - 2);
 
+    syncBattery();
     this->battery->decreaseBurnRate();
+    scheduleBatteryStep();
+
+    observer->powerLevelChanged(currentSession->getLastPowerLevel());
+    updateOutput();
 }
 
 /**
@@ -79,8 +582,10 @@ void CESDevice::decreasePower()
  */
 void CESDevice::selectFrequency(int choice)
 {
-    this->currentSession->setFrequency(choice);
+    EventScope logged(eventLog, EventLog::SelectFrequency, (quint64)choice);
 
+    this->currentSession->setFrequency(choice);
+    updateOutput();
 }
 
 
@@ -96,7 +601,10 @@ void CESDevice::selectFrequency(int choice)
  */
 void CESDevice::selectWaveform(int choice)
 {
+    EventScope logged(eventLog, EventLog::SelectWaveform, (quint64)choice);
+
     this->currentSession->setWaveform(choice);
+    updateOutput();
 }
 
 /**
@@ -111,6 +619,8 @@ void CESDevice::selectWaveform(int choice)
  */
 void CESDevice::selectTherapyTime(int choice)
 {
+    EventScope logged(eventLog, EventLog::SelectTherapyTime, (quint64)choice);
+
     switch(choice)
     {
     case 0:
@@ -122,9 +632,7 @@ void CESDevice::selectTherapyTime(int choice)
         this->currentSession->setLastDuration(20);
 
         //Update the display
-        QTime time = QTime(0,0,0).addSecs(20 * 60);
-        QString minuteSeconds = time.toString("mm:ss");
-        this->timerDisplay->display(minuteSeconds);
+        this->observer->timerDisplayChanged(DisplayText::countdown(20));
         break;
     }
     case 1:
@@ -132,9 +640,7 @@ void CESDevice::selectTherapyTime(int choice)
         this->currentSession->setDuration(40);
         this->currentSession->setLastDuration(40);
 
-        QTime time = QTime(0,0,0).addSecs(40 * 60);
-        QString minuteSeconds = time.toString("mm:ss");
-        this->timerDisplay->display(minuteSeconds);
+        this->observer->timerDisplayChanged(DisplayText::countdown(40));
         break;
     }
     case 2:
@@ -142,8 +648,7 @@ void CESDevice::selectTherapyTime(int choice)
         this->currentSession->setDuration(60);
         this->currentSession->setLastDuration(60);
 
-        //Special case where Qtime converts 60 minutes to hh:mm:ss
-        this->timerDisplay->display(QString::number(60)+":00");
+        this->observer->timerDisplayChanged(DisplayText::countdown(60));
         break;
     }
     default:
@@ -161,62 +666,42 @@ void CESDevice::startRecording() { this->isRecording = true; }
 
 
 /**
- * Saves the current recording to the list of recordings.
+ * Saves the current recording as a fixed-width record, appends it to the record store
+ * and counts it in the usage rollups.
  * Should only ever be called when the session ends or the system powers off.
  *
  * @param endTime -> the total time the session took (time(0) - startTime)
+ * @return the saved record
  */
-QString CESDevice::saveRecording(int endTime)
+SessionRecord CESDevice::saveRecording(int endTime)
 {
-    //Convert the epoch time startTime into a readable format
-    const QDateTime dt = QDateTime::fromTime_t(currentSession->getStartTime());
-    const QString textdate = dt.toString( Qt::DefaultLocaleShortDate );
-    QString tempString = QString("[");
-    tempString += textdate;
-    tempString += QString("]");
+    SessionRecord record;
+    memset(&record, 0, sizeof(record));
 
-    //Insert the ID into the string
-    tempString += QString::fromStdString("\nID: " + std::to_string(recordedSessionsIDs));
+    record.startTime = currentSession->getStartTime();
+    record.id = recordedSessionsIDs;
+    record.duration = endTime;
+    record.waveform = currentSession->getWaveform();
+    record.frequency = currentSession->getFrequency();
+    record.powerLevel = currentSession->getLastPowerLevel();
 
-    //Set the duration of the time into mm:ss format
-    tempString += ", Duration: " + QString::number(endTime) + ":00";
+    //Keep the record past the end of the program
+    if(recordStore != nullptr){
+        recordStore->append(record);
+    }
 
-    //Set the waveform of the string
-    switch(currentSession->getWaveform())
-    {
-    case 0:
-        tempString += QString(", Waveform: Alpha");
-        break;
-    case 1:
-        tempString += QString(", Waveform: Betta");
-        break;
-    case 2:
-        tempString += QString(", Waveform: Gamma");
-        break;
-    default:
-        break;
+    //Count it in the usage totals of its day and week
+    if(usageRollups != nullptr){
+        usageRollups->add(record);
     }
 
-    //Set the Frequency of the string, shortened to Freq
-    switch (currentSession->getFrequency())
-    {
-    case 0:
-        tempString += QString(", Freq: 0.5Hz");
-        break;
-    case 1:
-        tempString += QString(", Freq: 77Hz");
-        break;
-    case 2:
-        tempString += QString(", Freq: 100Hz");
-        break;
-    default:
-        break;
+    //Let a replay check it made the same record
+    if(eventLog != nullptr){
+        eventLog->note(EventLog::RecordSaved, EventLog::hash(record));
     }
 
-    //Set the powerlevel
-    tempString += QString::fromStdString(", Powerlevel: " + std::to_string(currentSession->getLastPowerLevel()));
     this->recordedSessionsIDs++; // increment the ID counter for future recordings
-    return tempString;
+    return record;
 }
 
 /**
@@ -227,6 +712,7 @@ QString CESDevice::saveRecording(int endTime)
  */
 void CESDevice::stopSession(int endTime)
 {
+    TraceScope trace("stopSession", "device");
 
     //No active sessions
     if(!isTreating)
@@ -239,55 +725,348 @@ void CESDevice::stopSession(int endTime)
     //Record if it was selected
     if(isRecording)
     {
-        this->recordList->insertItem(0, this->saveRecording(endTime));
-        isRecording = false;
+        this->observer->recordSaved(this->saveRecording(endTime));
+        setRecording(false);
     }
 
-    //Stop the device
-    if(currentSession->getInternalClock()->getTimer()->isActive())
-    {
-        //Stop the internal clock if it is running
-        currentSession->getInternalClock()->stopTimer();
+    //Stop the countdown where it is
+    currentSession->stopSession();
+
+    setIsTreating(false);
+}
+
+/**
+ * Captures the complete state of the device: flags, therapy, battery, inactivity, record ID
+ * and the pending deadlines of its timers, at the current time of its clock
+ *
+ * @return the snapshot
+ */
+DeviceSnapshot CESDevice::saveSnapshot()
+{
+    DeviceSnapshot snapshot;
+    memset(&snapshot, 0, sizeof(snapshot));
+
+    snapshot.version = DeviceSnapshot::VERSION;
+    snapshot.flags = (isOn ? DeviceSnapshot::IsOn : 0)
+                   | (isDisabled ? DeviceSnapshot::IsDisabled : 0)
+                   | (isRecording ? DeviceSnapshot::IsRecording : 0)
+                   | (isTreating ? DeviceSnapshot::IsTreating : 0)
+                   | (isContactingSkin ? DeviceSnapshot::IsContactingSkin : 0)
+                   | (currentSession->getIsRunning() ? DeviceSnapshot::IsRunning : 0)
+                   | (battery->getFiveWarning() ? DeviceSnapshot::FiveWarning : 0);
+    snapshot.time = scheduler->now();
+    snapshot.startTime = currentSession->getStartTime();
+    snapshot.batteryAnchor = batteryAnchor;
+
+    for(int i = 0; i < DeviceSnapshot::TIMERS; i++){
+        snapshot.deadlines[i] = timers[i]->getDeadline();
+        snapshot.intervals[i] = timers[i]->getInterval();
     }
 
-    this->isTreating = false;
+    //Timers with the same deadline fire in the order they were scheduled, keep it (stopped timers go last)
+    int order[DeviceSnapshot::TIMERS] = { 0, 1, 2, 3 };
+    std::sort(order, order + DeviceSnapshot::TIMERS, [this](int a, int b) {
+        Scheduler::EventId first = timers[a]->getEvent() - 1;   //0 (stopped) wraps to the largest
+        Scheduler::EventId second = timers[b]->getEvent() - 1;
+        return first < second;
+    });
+    for(int i = 0; i < DeviceSnapshot::TIMERS; i++){
+        snapshot.timerOrder |= (quint8)(order[i] << (2 * i));
+    }
 
+    snapshot.remaining = (qint32)currentSession->getRemaining();
+    snapshot.lastDuration = currentSession->getLastDuration();
+    snapshot.batteryPercentage = battery->getBatteryPercentage();
+    snapshot.burnRate = battery->getBurnRate();
+    snapshot.burnCount = battery->getBurnCount();
+    snapshot.inactiveSeconds = getInactiveSeconds();
+    snapshot.recordId = recordedSessionsIDs;
+    snapshot.waveform = (quint8)currentSession->getWaveform();
+    snapshot.frequency = (quint8)currentSession->getFrequency();
+    snapshot.powerLevel = (quint8)currentSession->getLastPowerLevel();
 
+    return snapshot;
 }
 
 /**
- * Update the display to decrement by 1 when ever a second passes
+ * Puts the device in the state of a snapshot, so it continues exactly as the device it was taken
+ * from did. The clock may be at another time (or be another clock): every time of the device's
+ * clock is moved by the difference. Start times of therapies (calendar times) stay as they were.
+ * The observer is told the whole restored state. A restore is not an input, it is not logged.
+ *
+ * @param snapshot is the state to continue from
+ * @return false if the snapshot is not of this version, the device is left as it was
  */
-void CESDevice::updateDisplay()
+bool CESDevice::restoreSnapshot(const DeviceSnapshot& snapshot)
 {
-    QString minuteSeconds = "";
-    int sessionDuration = this->currentSession->getDuration();
+    if(snapshot.version != DeviceSnapshot::VERSION){ return false; }
 
-    if(sessionDuration < 60){
-        QTime time = QTime(0,0,0).addSecs(this->currentSession->getDuration() * 60);
-        minuteSeconds = time.toString("mm:ss");
-    }else{
-        minuteSeconds = QString::number(sessionDuration)+"00";
+    qint64 shift = scheduler->now() - snapshot.time;
+
+    isOn = (snapshot.flags & DeviceSnapshot::IsOn) != 0;
+    isDisabled = (snapshot.flags & DeviceSnapshot::IsDisabled) != 0;
+    isRecording = (snapshot.flags & DeviceSnapshot::IsRecording) != 0;
+    isTreating = (snapshot.flags & DeviceSnapshot::IsTreating) != 0;
+    isContactingSkin = (snapshot.flags & DeviceSnapshot::IsContactingSkin) != 0;
+
+    currentSession->setWaveform(snapshot.waveform);
+    currentSession->setFrequency(snapshot.frequency);
+    currentSession->setLastPowerLevel(snapshot.powerLevel);
+    currentSession->setRemaining(snapshot.remaining, snapshot.deadlines[DeviceSnapshot::TherapyTimer] >= 0);
+    currentSession->setLastDuration(snapshot.lastDuration);
+    currentSession->setStartTime((time_t)snapshot.startTime);
+    currentSession->setIsRunning((snapshot.flags & DeviceSnapshot::IsRunning) != 0);
+
+    battery->setBatteryPercentage(snapshot.batteryPercentage);
+    battery->setBurnRate(snapshot.burnRate);
+    battery->setBurnCount(snapshot.burnCount);
+    battery->setFiveWarning((snapshot.flags & DeviceSnapshot::FiveWarning) != 0);
+    batteryAnchor = snapshot.batteryAnchor + shift;
+
+    //The count is counted from the time that leaves the minutes it has left before the inactivity deadline
+    inactiveSeconds = snapshot.inactiveSeconds;
+    inactiveSince = -1;
+    if(snapshot.deadlines[DeviceSnapshot::InactivityTimer] >= 0){
+        qint64 minutesLeft = (1800 - inactiveSeconds + 59) / 60;
+        inactiveSince = snapshot.deadlines[DeviceSnapshot::InactivityTimer] + shift - minutesLeft * 1000;
     }
+    recordedSessionsIDs = snapshot.recordId;
 
-    this->timerDisplay->display(minuteSeconds);
+    //Schedule the timers in their original order, so equal deadlines fire in the same order
+    for(int i = 0; i < DeviceSnapshot::TIMERS; i++){
+        int index = (snapshot.timerOrder >> (2 * i)) & 3;
+        timers[index]->setInterval(snapshot.intervals[index]);
+
+        if(snapshot.deadlines[index] < 0){
+            timers[index]->stopTimer();
+        }else{
+            timers[index]->startTimerAt(snapshot.deadlines[index] + shift);
+        }
+    }
+
+    //Show the restored state
+    observer->powerChanged(isOn);
+    observer->enabledChanged(!isDisabled);
+    observer->recordingChanged(isRecording);
+    observer->contactChanged(isContactingSkin);
+    observer->treatingChanged(isTreating);
+    observer->powerLevelChanged(currentSession->getLastPowerLevel());
+    observer->batteryChanged(battery->getBatteryPercentage());
+    observer->inactivityChanged(getInactiveSeconds());
+    updateDisplay();
+    updateOutput();
+
+    return true;
+}
+
+/**
+ * Update the display to the seconds left of the therapy
+ */
+void CESDevice::updateDisplay()
+{
+    this->observer->timerDisplayChanged(DisplayText::countdown(this->currentSession->getDuration()));
 }
 
 //Getters/Setters
 Battery* CESDevice::getBattery(){ return this->battery; }
 TherapySession* CESDevice::getCurrSession() { return this->currentSession; }
 
-void CESDevice::setContact(bool state) { this->isContactingSkin = state; }
+/**
+ * Set whether the electrodes touch the skin, and tell the observer.
+ * The output only runs while they do.
+ *
+ * @param state is true if the electrodes touch the skin
+ */
+void CESDevice::setContact(bool state)
+{
+    this->isContactingSkin = state;
+    Trace::instant(state ? "skin contact" : "no skin contact");
+
+    observer->contactChanged(state);
+    updateOutput();
+}
+
 bool CESDevice::getContact(){ return this->isContactingSkin; }
 
 bool CESDevice::getIsOn(){ return this->isOn; }
-void CESDevice::setIsOn(bool choice){ this->isOn = choice; }
+
+/**
+ * Turn the device on or off, and tell the observer.
+ * The output and the inactivity count follow the new state.
+ *
+ * @param choice is true to turn the device on
+ */
+void CESDevice::setIsOn(bool choice)
+{
+    this->isOn = choice;
+    Trace::instant(choice ? "on" : "off");
+
+    observer->powerChanged(choice);
+    updateOutput();
+    countInactivity();
+}
 
 bool CESDevice::getIsTreating(){ return this->isTreating; }
-void CESDevice::setIsTreating(bool choice){ this->isTreating = choice;  }
+
+/**
+ * Set whether a therapy is running, and tell the observer.
+ * The device is not inactive while it treats, the output and the inactivity count follow.
+ *
+ * @param choice is true if a therapy is running
+ */
+void CESDevice::setIsTreating(bool choice)
+{
+    this->isTreating = choice;
+    Trace::instant(choice ? "treating" : "not treating");
+
+    observer->treatingChanged(choice);
+    updateOutput();
+    countInactivity();
+}
 
 bool CESDevice::getRecording(){ return this->isRecording; }
-void CESDevice::setRecording(bool choice){ this->isRecording = choice; }
 
-void CESDevice::setIsDisabled(bool choice){ this->isDisabled = choice; }
+/**
+ * Set whether the current therapy is recorded when it ends, and tell the observer
+ *
+ * @param choice is true to record the therapy
+ */
+void CESDevice::setRecording(bool choice)
+{
+    this->isRecording = choice;
+    Trace::instant(choice ? "recording" : "not recording");
+
+    observer->recordingChanged(choice);
+}
+
+/**
+ * Disable or enable the device from the admin area, and tell the observer.
+ * A disabled device cannot be turned on.
+ *
+ * @param choice is true to disable the device
+ */
+void CESDevice::setIsDisabled(bool choice)
+{
+    this->isDisabled = choice;
+    Trace::instant(choice ? "disabled" : "enabled");
+
+    observer->enabledChanged(!choice);
+}
+
 bool CESDevice::getIsDisabled(){ return this->isDisabled; }
+
+int CESDevice::getInactiveSeconds()
+{
+    if(inactiveSince < 0){ return this->inactiveSeconds; }
+
+    //A minute for every second of the clock, up to the 30 minutes that turn the device off
+    qint64 seconds = inactiveSeconds + (scheduler->now() - inactiveSince) / 1000 * 60;
+    return (int)(seconds < 1800 ? seconds : 1800);
+}
+DeviceObserver* CESDevice::getObserver(){ return this->observer; }
+Scheduler* CESDevice::getScheduler(){ return this->scheduler; }
+
+/**
+ * Set the output thread that plays the waveform of the device, and bring it to the current state
+ *
+ * @param output is the output thread, nullptr for none
+ */
+void CESDevice::setOutput(OutputThread* output)
+{
+    this->output = output;
+    updateOutput();
+}
+
+/**
+ * Adds every recorded session to a record store. IDs continue after the records already in the store.
+ * @param store is an open record store, nullptr to stop recording to it
+ */
+void CESDevice::setRecordStore(RecordStore* store)
+{
+    this->recordStore = store;
+
+    if(store != nullptr){
+        this->recordedSessionsIDs = (int)store->count();
+    }
+}
+
+/**
+ * Counts every recorded session in usage rollups
+ * @param rollups is the rollups to update, nullptr to stop counting
+ */
+void CESDevice::setUsageRollups(UsageRollups* rollups){ this->usageRollups = rollups; }
+
+/**
+ * Set where the therapy, battery and inactivity timers record how late they fire
+ * and how long they run, in histograms named after the functions they call,
+ * and where the therapy records how much longer than its length it ran ("drift therapy")
+ *
+ * @param stats is the latency stats to record to, nullptr to stop recording
+ */
+void CESDevice::setLatencyStats(LatencyStats* stats)
+{
+    if(stats == nullptr){
+        currentSession->getInternalClock()->setLatency(nullptr, nullptr);
+        batteryTimer->setLatency(nullptr, nullptr);
+        inactivityTimer->setLatency(nullptr, nullptr);
+        currentSession->setDriftHistogram(nullptr);
+        return;
+    }
+
+    currentSession->getInternalClock()->setLatency(stats->histogram("late timerTimeout"), stats->histogram("run timerTimeout"));
+    batteryTimer->setLatency(stats->histogram("late batteryUpdate"), stats->histogram("run batteryUpdate"));
+    inactivityTimer->setLatency(stats->histogram("late inactivityUpdate"), stats->histogram("run inactivityUpdate"));
+    currentSession->setDriftHistogram(stats->histogram("drift therapy"));
+}
+
+/**
+ * Logs every input of the device and every firing of its timers, with the battery percentages
+ * and saved records they lead to. Set right after the device was made, so a replay starts
+ * from the same state.
+ *
+ * @param log is an open event log on the device's clock, nullptr to stop logging
+ */
+void CESDevice::setEventLog(EventLog* log)
+{
+    this->eventLog = log;
+
+    currentSession->getInternalClock()->setEventLog(log, EventLog::TherapyTimer);
+    batteryTimer->setEventLog(log, EventLog::BatteryTimer);
+    inactivityTimer->setEventLog(log, EventLog::InactivityTimer);
+    skinOffTimer->setEventLog(log, EventLog::SkinOffTimer);
+}
+
+/**
+ * Get the ID the next saved record gets
+ * @return the ID
+ */
+int CESDevice::getNextRecordId(){ return this->recordedSessionsIDs; }
+
+/**
+ * Set the ID the next saved record gets, so a replay numbers its records like the logged run
+ * @param id is the ID of the next record
+ */
+void CESDevice::setNextRecordId(int id){ this->recordedSessionsIDs = id; }
+
+/**
+ * Time of the device's clock at which the battery loses its next 1% at the current burn rate
+ * @return the time in ms
+ */
+qint64 CESDevice::nextBatteryStepTime()
+{
+    return batteryAnchor + (qint64)battery->secondsUntilNextStep() * 1000;
+}
+
+
+/**
+ * Time of the device's clock at which the battery reaches the given percentage
+ * (for example the 5% or 2% warnings) if the device stays on at the current burn rate
+ *
+ * @param percentage is the battery percentage to reach
+ * @return the time in ms, -1 if the battery is already at or below it
+ */
+qint64 CESDevice::batteryPercentageTime(int percentage)
+{
+    qint64 seconds = battery->secondsUntilPercentage(percentage);
+    return seconds < 0 ? -1 : batteryAnchor + seconds * 1000;
+}
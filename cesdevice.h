@@ -2,13 +2,20 @@
 #define CESDEVICE_H
 
 #include <ctime>
-#include <QTimer>
-#include <QLCDNumber>
-#include <QListWidget>
 #include <iomanip>
 
 #include "therapysession.h"
+#include "scheduler.h"
+#include "timer.h"
 #include "battery.h"
+#include "deviceobserver.h"
+#include "devicesnapshot.h"
+#include "eventlog.h"
+#include "latencystats.h"
+#include "outputthread.h"
+#include "recordstore.h"
+#include "sessionrecord.h"
+#include "usagerollups.h"
 
 /*
 Class: CESDevice
@@ -20,8 +27,15 @@ Usage: Controls the device, therapy sessions, the battery, and the therapy timer
         - Can increase of decrease the power of the device
         - Sets the frequency, duration and waveform for the therapy session
         - Starts and stop sessions
-        - Records therapy sessions
-        - displays the therapy timer to the device
+        - Records therapy sessions (to its RecordStore, if it has one)
+        - Reacts to the power button, skin contact, admin changes, battery and inactivity timers
+        - Counts inactivity from the clock: nothing runs while the device is idle but one timer at the
+          time it turns off, which resetInactivity() moves back
+        - Reports every change to its DeviceObserver (it never touches a widget)
+        - Sends the output current settings to its OutputThread, if it has one
+        - Records how late its timers fire and how long they run in LatencyStats, if it has them
+        - Logs its inputs, timer firings, battery percentages and records in an EventLog, if it has one
+        - Saves its complete state to a DeviceSnapshot and continues from one
         - Provides getters/setters for battery, therapysession, skin contact, disabled status, treating status, recording status, and power status
 */
 
@@ -29,18 +43,33 @@ Usage: Controls the device, therapy sessions, the battery, and the therapy timer
 class CESDevice
 {
 public:
-    CESDevice(QLCDNumber* display, QListWidget* recordList);
+    CESDevice(Scheduler* scheduler, DeviceObserver* observer = nullptr);
     ~CESDevice();
 
+    //Inputs from the buttons, the admin area and the timers
+    void pressPower();                              //Turn the device on or off (power button)
+    void toggleRecording();                         //Turn recording on or off (record button)
+    void changeSkinContact(bool contact);           //The earclips touched or left the skin
+    void changeDeviceEnabled(bool enabled);         //Disable or re-enable the device from the admin area
+    void changePowerLevel(int level);               //Set the power level in uA from the admin area
+    void changeBatteryPercentage(int percentage);   //Set the battery percentage from the admin area
+    void batteryUpdate();                           //Called every second by the battery timer
+    void inactivityUpdate();                        //Add a minute to the inactive time (from the admin area)
+    void skinContactUpdate();                       //Called 5 seconds after skin contact was lost during a therapy
+    void resetInactivity();                         //Set the inactive time back to zero
+    void finishSession();                           //Reset the device once the therapy timer ran out
+
     void increasePower();                           //increase the power level by 50mu
     void decreasePower();                           //descrease the power level by 100mu
     void selectFrequency(int choice);               //Call currentSession and set the frequency
     void selectWaveform(int choice);                //call currentSession and set the waveform
     void selectTherapyTime(int choice);             //call currentSession and set the length of the therapy
     void startRecording();                          //Set the system to record the current session
-    QString saveRecording(int endTime);             //Save the session to the list of sessions
+    SessionRecord saveRecording(int endTime);       //Save the session to the record store
     void updateDisplay();                           //Update the display whenever the timer times out
     void stopSession(int endTime);                  //End the current session immediatly
+    DeviceSnapshot saveSnapshot();                  //Capture the complete state of the device
+    bool restoreSnapshot(const DeviceSnapshot& snapshot);   //Continue from a snapshot, false if it is not of this version
 
     //Getter/Setters
     TherapySession* getCurrSession();                   //Return the current session object
@@ -55,18 +84,51 @@ public:
     bool getRecording();                                //Get whether the device will record a therapy or not
     void setIsDisabled(bool choice);                    //Set whether the device is disbaled or not
     bool getIsDisabled();                               //Get whether the device is disabled or not
+    int getInactiveSeconds();                           //Get the number of seconds the device has been inactive (worked out from the clock)
+    DeviceObserver* getObserver();                      //Return the observer the device reports to
+    Scheduler* getScheduler();                          //Return the clock all timers of the device run on
+    void setOutput(OutputThread* output);               //Send the output current settings to an output thread (nullptr for none)
+    void setRecordStore(RecordStore* store);            //Add recorded sessions to an open record store (nullptr for none)
+    void setUsageRollups(UsageRollups* rollups);        //Count recorded sessions in usage rollups (nullptr for none)
+    void setLatencyStats(LatencyStats* stats);          //Record the lateness and run time of the timers (nullptr for none)
+    void setEventLog(EventLog* log);                    //Log the inputs and timer firings of the device (nullptr for none)
+    int getNextRecordId();                              //Get the ID the next saved record gets
+    void setNextRecordId(int id);                       //Set the ID the next saved record gets (to replay a logged run)
+    qint64 nextBatteryStepTime();                       //Time at which the battery loses its next 1%
+    qint64 batteryPercentageTime(int percentage);       //Time at which the battery reaches the percentage, -1 if it already did
 
 private:
     TherapySession* currentSession;                 //The current session of the machine
     int recordedSessionsIDs;                        //Count of the recorded session IDs
+    RecordStore* recordStore;                       //Keeps the recorded sessions, may be nullptr
+    UsageRollups* usageRollups;                     //Per-day and per-week totals of the recorded sessions, may be nullptr
     Battery* battery;                               //Simulate the battery
-    QLCDNumber* timerDisplay;                       //Allow the device to update the timer itself
-    QListWidget* recordList;                        //Allow device to update the list of records
+    DeviceObserver* observer;                       //Receives every change of the device (display, records, status)
+    Scheduler* scheduler;                           //Clock all timers of the device run on (may be shared with other devices)
+    OutputThread* output;                           //Produces the output current, may be nullptr
+    EventLog* eventLog;                             //Logs the inputs and timer firings, may be nullptr
+    Timer* batteryTimer;                            //Depletes the battery every second while the device is on
+    Timer* inactivityTimer;                         //Turns the device off after 30 minutes of inactivity, only runs while it is counted
+    Timer* skinOffTimer;                            //Ends a paused therapy 5 seconds after skin contact was lost
+    Timer* timers[DeviceSnapshot::TIMERS];          //The therapy, battery, inactivity and skin contact timers, in snapshot order
+    int inactiveSeconds;                            //Seconds the device had been inactive at inactiveSince (or while it is not counted)
+    qint64 inactiveSince;                           //Time of the clock inactivity is counted from (a minute per second), -1 while it is not counted
+    qint64 batteryAnchor;                           //Time up to which the battery has been depleted (whole seconds since it turned on)
     bool isContactingSkin;                          //Are the earclips connected to the skin
     bool isOn;                                      //Is the power on or not
     bool isDisabled;                                //Has the device has been "permanently" disabled or not
     bool isRecording;                               //Should the system save the session when it ends
     bool isTreating;                                //Is the device treating or not
+
+    void turnOff();                                 //Turn off the device and stop its timers
+    void syncBattery();                             //Deplete the battery for the seconds since it was last depleted
+    void scheduleBatteryStep();                     //Set the battery timer to the next 1% step
+    void inactivityTimeout();                       //Called by the inactivity timer after 30 minutes of inactivity
+    void countInactivity();                         //Start or hold the inactivity count as the device turns on/off or treats
+    void scheduleInactivityOff();                   //Set the inactivity timer to the time the count reaches 30 minutes
+    void resetSessionSettings();                    //Return recording/power level/burn rate to their defaults after a session
+    void updateOutput();                            //Send the current output settings to the output thread
+    void reportBattery();                           //Report the battery percentage to the observer (and the event log)
 };
 
 #endif // CESDEVICE_H
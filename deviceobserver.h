@@ -0,0 +1,44 @@
+#ifndef DEVICEOBSERVER_H
+#define DEVICEOBSERVER_H
+
+#include <QString>
+
+#include "sessionrecord.h"
+
+/*
+Class: DeviceObserver
+
+Purpose: This class is the only channel through which the CES device core reports
+         changes to the outside world (the Qt widgets, a headless runner, a test, ...)
+
+Usage: Subclass it and override the notifications you care about, then pass it to the CESDevice.
+       Every notification has an empty default so an observer only implements what it needs.
+       Notifications:
+        - therapy timer display text changed
+        - a therapy session was recorded
+        - power, treating, recording, skin contact and enabled status changed
+        - power level, battery percentage and inactivity time changed
+        - battery warnings (5% and 2%)
+        - a therapy session ended and the device was reset for the next one
+*/
+
+class DeviceObserver
+{
+public:
+    virtual ~DeviceObserver() {}
+
+    virtual void timerDisplayChanged(const QString& text) { (void)text; }   //The large therapy timer shows a new value
+    virtual void recordSaved(const SessionRecord& record) { (void)record; } //A finished session was recorded
+    virtual void powerChanged(bool isOn) { (void)isOn; }                    //The device was turned on or off
+    virtual void treatingChanged(bool isTreating) { (void)isTreating; }     //The device started or stopped treating
+    virtual void recordingChanged(bool isRecording) { (void)isRecording; }  //Recording was turned on or off
+    virtual void contactChanged(bool isContacting) { (void)isContacting; }  //The earclips touched or left the skin
+    virtual void enabledChanged(bool isEnabled) { (void)isEnabled; }        //The device was disabled or re-enabled
+    virtual void powerLevelChanged(int level) { (void)level; }              //The power level changed (0 - 10, 50uA per level)
+    virtual void batteryChanged(int percentage) { (void)percentage; }       //The battery percentage changed
+    virtual void batteryWarning(int percentage) { (void)percentage; }       //The battery reached 5% or 2%
+    virtual void inactivityChanged(int seconds) { (void)seconds; }          //The inactive time was reset, increased or reached 30 minutes (it counts on its own in between)
+    virtual void sessionEnded() {}                                          //A session finished and the device reset for the next one
+};
+
+#endif // DEVICEOBSERVER_H
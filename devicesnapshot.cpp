@@ -0,0 +1,35 @@
+#include "devicesnapshot.h"
+
+#include <QFile>
+
+/**
+ * Writes the snapshot to a file as it is, replacing the file
+ *
+ * @param path is the path of the file
+ * @return false if the snapshot could not be written
+ */
+bool DeviceSnapshot::save(const QString& path) const
+{
+    QFile file(path);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)){
+        return false;
+    }
+
+    return file.write((const char*)this, sizeof(DeviceSnapshot)) == (qint64)sizeof(DeviceSnapshot) && file.flush();
+}
+
+/**
+ * Reads a snapshot from a file
+ *
+ * @param path is the path of the file
+ * @return false if the file can't be read or does not hold a snapshot of this version
+ */
+bool DeviceSnapshot::load(const QString& path)
+{
+    QFile file(path);
+    if(!file.open(QIODevice::ReadOnly) || file.size() != (qint64)sizeof(DeviceSnapshot)){
+        return false;
+    }
+
+    return file.read((char*)this, sizeof(DeviceSnapshot)) == (qint64)sizeof(DeviceSnapshot) && version == VERSION;
+}
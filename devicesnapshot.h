@@ -0,0 +1,66 @@
+#ifndef DEVICESNAPSHOT_H
+#define DEVICESNAPSHOT_H
+
+#include <QString>
+#include <QtGlobal>
+
+/*
+Struct: DeviceSnapshot
+
+Purpose: The complete state of a CES device at one time of its clock, in the fixed-width binary form it is stored in.
+
+Usage: CESDevice::saveSnapshot() fills one, CESDevice::restoreSnapshot() continues from it, on any
+       device and any clock. Plain data, 112 bytes, no pointers, so it is saved and loaded as is:
+        - time of the clock it was taken at, every other clock time is moved along with it on restore
+        - power, treating, recording, skin contact, disabled and 5% warning flags
+        - the therapy: waveform, frequency, power level, remaining time (ms) and selected duration, start time, running
+        - the battery: percentage, burn rate, burn count, and up to when it has been depleted
+        - inactive seconds and the ID of the next record
+        - the pending deadline and interval of the therapy, battery, inactivity and skin contact timers,
+          and the order they were scheduled in (which fires first on equal deadlines)
+       save() and load() keep one in a file.
+*/
+
+struct DeviceSnapshot
+{
+    enum Flag
+    {
+        IsOn = 1,
+        IsDisabled = 2,
+        IsRecording = 4,
+        IsTreating = 8,
+        IsContactingSkin = 16,
+        IsRunning = 32,         //The therapy is running (not paused)
+        FiveWarning = 64        //The 5% warning was given
+    };
+
+    enum TimerIndex { TherapyTimer, BatteryTimer, InactivityTimer, SkinOffTimer, TIMERS };
+
+    quint32 version;            //VERSION of the layout
+    quint32 flags;              //Flags that are set
+    qint64 time;                //Time of the device's clock the snapshot was taken at (ms)
+    qint64 startTime;           //Start time of the therapy (seconds since the epoch)
+    qint64 batteryAnchor;       //Time up to which the battery has been depleted (ms)
+    qint64 deadlines[TIMERS];   //Next deadline of each timer (ms), -1 if it is stopped
+    qint32 intervals[TIMERS];   //Interval of each timer (ms)
+    qint32 remaining;           //Remaining time of the therapy (ms)
+    qint32 lastDuration;        //Selected duration of the therapy
+    qint32 batteryPercentage;   //Percentage of the battery
+    qint32 burnRate;            //Seconds it takes to burn a percentage
+    qint32 burnCount;           //Seconds since the last percentage was burnt
+    qint32 inactiveSeconds;     //Seconds the device has been inactive (counted on to the inactivity deadline)
+    qint32 recordId;            //ID of the next saved record
+    quint8 waveform;            //0 - Alpha, 1 - Beta, 2 - Gamma
+    quint8 frequency;           //0 - 0.5Hz, 1 - 77Hz, 2 - 100Hz
+    quint8 powerLevel;          //Last power level, 0 - 10 (50uA per level)
+    quint8 timerOrder;          //Timer indexes in the order their deadlines were scheduled (2 bits each, first in the lowest)
+
+    static const quint32 VERSION = 3;
+
+    bool save(const QString& path) const;   //Write the snapshot to a file, false if it could not be written
+    bool load(const QString& path);         //Read a snapshot from a file, false if it is not a snapshot of this version
+};
+
+static_assert(sizeof(DeviceSnapshot) == 112, "DeviceSnapshot is stored as is, its size must not change");
+
+#endif // DEVICESNAPSHOT_H
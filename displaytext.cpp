@@ -0,0 +1,54 @@
+#include "displaytext.h"
+
+#include <vector>
+
+/**
+ * Formats the text of every value of the timers, from 00:00 to 60:00
+ *
+ * @return the texts, indexed by the number of seconds
+ */
+static std::vector<QString> makeTable()
+{
+    std::vector<QString> table;
+    table.reserve(DisplayText::MAX_SECONDS + 1);
+
+    for(int seconds = 0; seconds <= DisplayText::MAX_SECONDS; seconds++){
+        char text[6] = {
+            (char)('0' + seconds / 600), (char)('0' + seconds / 60 % 10), ':',
+            (char)('0' + seconds % 60 / 10), (char)('0' + seconds % 10), '\0'
+        };
+        table.push_back(QString::fromLatin1(text));
+    }
+
+    return table;
+}
+
+/**
+ * Text of a number of seconds as "mm:ss"
+ *
+ * @param seconds is the time to show, 0 - MAX_SECONDS
+ * @return the text, shared by every caller
+ */
+const QString& DisplayText::clock(int seconds)
+{
+    //Made on first use, thread safe
+    static const std::vector<QString> table = makeTable();
+
+    if(seconds < 0){ seconds = 0; }
+    if(seconds > MAX_SECONDS){ seconds = MAX_SECONDS; }
+    return table[seconds];
+}
+
+/**
+ * Text of the remaining therapy time. The device counts the therapy down a whole minute
+ * at a time, so the seconds are always 00.
+ *
+ * @param minutes is the remaining time, 0 - 60
+ * @return the text, shared by every caller
+ */
+const QString& DisplayText::countdown(int minutes)
+{
+    if(minutes < 0){ minutes = 0; }
+    if(minutes > MAX_SECONDS / 60){ minutes = MAX_SECONDS / 60; }
+    return clock(minutes * 60);
+}
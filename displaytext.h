@@ -0,0 +1,30 @@
+#ifndef DISPLAYTEXT_H
+#define DISPLAYTEXT_H
+
+#include <QString>
+
+/*
+Namespace: DisplayText
+
+Purpose: The "mm:ss" texts of the device's LCD timers, made once and shared.
+
+Usage: Every value the timers can show, 00:00 to 60:00, is formatted once into a table the
+       first time a text is asked for. After that a tick only looks up its text, no QTime
+       arithmetic, no formatting and no allocation (the QString is implicitly shared).
+        - clock(seconds): a number of seconds, e.g. the inactivity timer
+        - countdown(minutes): the remaining therapy time, which the device counts in whole minutes
+       Both show 60 minutes as "60:00", values out of range show the nearest end of the table.
+*/
+
+namespace DisplayText
+{
+
+//Longest time the timers show, in seconds (60:00)
+const int MAX_SECONDS = 60 * 60;
+
+const QString& clock(int seconds);      //"mm:ss" of a number of seconds, 0 - MAX_SECONDS
+const QString& countdown(int minutes);  //"mm:00" of a remaining therapy time in minutes, 0 - 60
+
+}
+
+#endif // DISPLAYTEXT_H
@@ -0,0 +1,299 @@
+#include "eventlog.h"
+
+#include <cstring>
+
+/**
+ * Magic bytes at the start of every event log
+ */
+static const char MAGIC[8] = { 'C', 'E', 'S', 'E', 'V', 'T', 'v', '1' };
+
+/**
+ * Buffered bytes at which the events are written to the file
+ */
+static const int BLOCK_SIZE = 4096;
+
+
+/**
+ * Appends a value as a base 128 varint (7 bits per byte, lowest first, high bit set on all but the last)
+ *
+ * @param out receives the bytes
+ * @param value is the value to append
+ */
+static void putVarint(QByteArray& out, quint64 value)
+{
+    while(value >= 0x80){
+        out.append((char)(value | 0x80));
+        value >>= 7;
+    }
+    out.append((char)value);
+}
+
+/**
+ * Reads a base 128 varint
+ *
+ * @param data is the first byte of the varint, moved past it
+ * @param end is the end of the data
+ * @param value receives the value
+ * @return false if the data ends before the varint does
+ */
+static bool getVarint(const char*& data, const char* end, quint64& value)
+{
+    value = 0;
+    for(int shift = 0; data < end && shift < 64; shift += 7){
+        quint8 byte = (quint8)*data++;
+        value |= (quint64)(byte & 0x7f) << shift;
+        if((byte & 0x80) == 0){ return true; }
+    }
+    return false;
+}
+
+
+/**
+ * Constructor for the EventLog. Nothing is logged until it is opened.
+ *
+ * @param scheduler is the clock of the device, events are logged with its time
+ * @param path is the path of the log file, empty to keep the log in memory
+ */
+EventLog::EventLog(Scheduler* scheduler, const QString& path) : path(path), file(path)
+{
+    this->scheduler = scheduler;
+    this->lastTime = 0;
+    this->count = 0;
+    this->depth = 0;
+    this->isOpen = false;
+}
+
+/**
+ * Deconstructor for the EventLog, writes what is left and closes the file
+ */
+EventLog::~EventLog()
+{
+    close();
+}
+
+/**
+ * Starts a new log. The file (if any) is replaced and gets the header, times are logged
+ * relative to clock 0 of the scheduler.
+ *
+ * @param firstRecordId is the ID the device gives its next saved record
+ * @return false if the file can't be made
+ */
+bool EventLog::open(int firstRecordId)
+{
+    close();
+
+    buffer.clear();
+    lastTime = 0;
+    count = 0;
+
+    if(!path.isEmpty()){
+        if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)){
+            return false;
+        }
+
+        char header[HEADER_SIZE];
+        quint32 version = VERSION;
+        quint32 recordId = (quint32)firstRecordId;
+        qint64 epoch = (qint64)scheduler->getEpoch();
+
+        memset(header, 0, HEADER_SIZE);
+        memcpy(header, MAGIC, 8);
+        memcpy(header + 8, &version, 4);
+        memcpy(header + 12, &recordId, 4);
+        memcpy(header + 16, &epoch, 8);
+
+        if(file.write(header, HEADER_SIZE) != HEADER_SIZE){
+            file.close();
+            return false;
+        }
+    }
+
+    isOpen = true;
+    return true;
+}
+
+/**
+ * Writes the buffered events and closes the file. Nothing is logged after this.
+ */
+void EventLog::close()
+{
+    if(!isOpen){ return; }
+
+    flush();
+    file.close();
+    isOpen = false;
+}
+
+/**
+ * Writes the buffered events to the file. A log without a path keeps them.
+ *
+ * @return false if they could not be written
+ */
+bool EventLog::flush()
+{
+    if(path.isEmpty() || !file.isOpen() || buffer.size() == 0){ return true; }
+
+    bool written = file.write(buffer.constData(), buffer.size()) == buffer.size() && file.flush();
+    buffer.clear();
+    return written;
+}
+
+/**
+ * An input or timer of the device starts. It is logged (and the clock held at its time
+ * until it is done) unless another logged input or timer is still running, which made the call.
+ *
+ * @param kind is the input or timer
+ * @param value is its value, 0 if it has none
+ * @return true if it was logged
+ */
+bool EventLog::enter(Kind kind, quint64 value)
+{
+    if(depth++ > 0 || !isOpen){ return false; }
+
+    scheduler->holdClock();
+    write(kind, value);
+    return true;
+}
+
+/**
+ * The input or timer that entered last is done. Lets the clock run again once nothing logged is running.
+ */
+void EventLog::leave()
+{
+    if(--depth == 0){
+        scheduler->releaseClock();
+    }
+}
+
+/**
+ * Logs what the device did (a battery percentage or a saved record), for a replay to check against
+ *
+ * @param kind is BatteryChanged or RecordSaved
+ * @param value is the percentage or the hash of the record
+ */
+void EventLog::note(Kind kind, quint64 value)
+{
+    if(isOpen){ write(kind, value); }
+}
+
+/**
+ * Encodes an event at the current time of the clock and writes the buffer out once it holds a block
+ *
+ * @param kind is what happened
+ * @param value depends on the kind
+ */
+void EventLog::write(Kind kind, quint64 value)
+{
+    //The clock never goes back, the delta is never negative
+    qint64 time = scheduler->now();
+    qint64 delta = time > lastTime ? time - lastTime : 0;
+    lastTime += delta;
+
+    buffer.append((char)kind);
+    putVarint(buffer, (quint64)delta);
+    putVarint(buffer, value);
+    count++;
+
+    if(!path.isEmpty() && buffer.size() >= BLOCK_SIZE){
+        flush();
+    }
+}
+
+/**
+ * Get the encoded events that were not written to a file yet. For a log without a path
+ * that is every event, without the header.
+ *
+ * @return the encoded events
+ */
+const QByteArray& EventLog::getData(){ return buffer; }
+
+/**
+ * Get the number of events logged since the log was opened
+ * @return the number of events
+ */
+qint64 EventLog::getCount(){ return count; }
+
+/**
+ * Hash of every byte of a record (64 bit FNV-1a), the value a saved record is logged with
+ *
+ * @param record is the saved record
+ * @return the hash
+ */
+quint64 EventLog::hash(const SessionRecord& record)
+{
+    const quint8* bytes = (const quint8*)&record;
+    quint64 hash = 14695981039346656037ULL;
+
+    for(size_t i = 0; i < sizeof(SessionRecord); i++){
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+/**
+ * Loads a log file with a single read
+ *
+ * @param path is the path of the log file
+ * @param epoch receives the calendar time of clock 0 of the logged run
+ * @param firstRecordId receives the ID the device gave its first saved record
+ * @param events receives the events, oldest first
+ * @return false if the file can't be read or is not an event log of this version
+ */
+bool EventLog::read(const QString& path, time_t& epoch, int& firstRecordId, std::vector<Event>& events)
+{
+    QFile file(path);
+    if(!file.open(QIODevice::ReadOnly)){
+        return false;
+    }
+
+    qint64 size = file.size();
+    if(size < HEADER_SIZE){ return false; }
+
+    std::vector<char> data(size);
+    if(file.read(data.data(), size) != size || memcmp(data.data(), MAGIC, 8) != 0){
+        return false;
+    }
+
+    quint32 version;
+    quint32 recordId;
+    qint64 start;
+    memcpy(&version, data.data() + 8, 4);
+    memcpy(&recordId, data.data() + 12, 4);
+    memcpy(&start, data.data() + 16, 8);
+    if(version != VERSION){ return false; }
+
+    epoch = (time_t)start;
+    firstRecordId = (int)recordId;
+    return decode(data.data() + HEADER_SIZE, size - HEADER_SIZE, events);
+}
+
+/**
+ * Decodes events. An event cut short at the end (a write that did not finish) is dropped.
+ *
+ * @param data is the first encoded event
+ * @param size is the number of bytes
+ * @param events receives the events, oldest first
+ * @return false if the data holds something that is not an event
+ */
+bool EventLog::decode(const char* data, qint64 size, std::vector<Event>& events)
+{
+    const char* end = data + size;
+    qint64 time = 0;
+
+    events.clear();
+    while(data < end){
+        quint8 kind = (quint8)*data++;
+        if(kind < PressPower || kind > RecordSaved){ return false; }
+
+        quint64 delta;
+        quint64 value;
+        if(!getVarint(data, end, delta) || !getVarint(data, end, value)){ break; }
+
+        time += (qint64)delta;
+        events.push_back(Event{time, value, (Kind)kind});
+    }
+
+    return true;
+}
@@ -0,0 +1,135 @@
+#ifndef EVENTLOG_H
+#define EVENTLOG_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <vector>
+
+#include "scheduler.h"
+#include "sessionrecord.h"
+
+/*
+Class: EventLog
+
+Purpose: This class records everything from outside that drives a CES device, so the run can be replayed exactly.
+
+Usage: Give it to CESDevice::setEventLog() right after the device was made. It then logs, with the
+       time of the device's clock:
+        - every input of the device (the buttons and the admin area, as the device calls they make)
+        - every firing of the device's timers (therapy, battery, inactivity, skin contact)
+        - the battery percentages and saved records, so a replay can check it still matches
+       An input or timer is only logged when nothing else logged is running, the calls it makes
+       itself are not. While it runs, the clock is held at the logged time, so a real time run sees
+       exactly the time the replay will.
+
+       The file starts with a 32 byte header (magic "CESEVTv1", format version, calendar time of
+       clock 0, first record ID) followed by the events, each a kind byte, the ms since the previous
+       event and a value, both as base 128 varints (3 - 4 bytes for most events).
+       Events are buffered and written in 4KB blocks, by flush() and when the log is closed.
+       Without a path the log is only kept in memory (getData()).
+       EventReplay re-drives a device from a log.
+*/
+
+class EventLog
+{
+public:
+    enum Kind
+    {
+        //Inputs
+        PressPower = 1,
+        ToggleRecording,
+        SkinContact,            //value: 1 on the skin, 0 off
+        DeviceEnabled,          //value: 1 enabled, 0 disabled
+        PowerLevel,             //value: the level in uA
+        BatteryPercentage,      //value: the percentage
+        InactivityUpdate,
+        ResetInactivity,
+        IncreasePower,
+        DecreasePower,
+        SelectFrequency,        //value: the choice
+        SelectWaveform,         //value: the choice
+        SelectTherapyTime,      //value: the choice
+
+        //Timers
+        TherapyTimer,
+        BatteryTimer,
+        InactivityTimer,
+        SkinOffTimer,
+
+        //Checks
+        BatteryChanged,         //value: the percentage
+        RecordSaved             //value: hash of the record
+    };
+
+    struct Event
+    {
+        qint64 time;            //Time of the device's clock in ms
+        quint64 value;          //Depends on the kind
+        Kind kind;              //What happened
+
+        bool operator==(const Event& other) const { return time == other.time && value == other.value && kind == other.kind; }
+    };
+
+    EventLog(Scheduler* scheduler, const QString& path = QString());
+    ~EventLog();
+
+    bool open(int firstRecordId);               //Start a new log (the file is replaced), false if the file can't be made
+    void close();                               //Write what is left and close the file
+    bool flush();                               //Write the buffered events to the file
+    bool enter(Kind kind, quint64 value = 0);   //An input or timer starts, logged if nothing logged is running. Must be followed by leave()
+    void leave();                               //The input or timer that entered last is done
+    void note(Kind kind, quint64 value);        //Log a check of what the device did
+
+    //Getters
+    const QByteArray& getData();                //Events not written to the file yet (all of them without a path)
+    qint64 getCount();                          //Number of events logged
+
+    static quint64 hash(const SessionRecord& record);   //Value a saved record is logged with
+    static bool read(const QString& path, time_t& epoch, int& firstRecordId, std::vector<Event>& events);  //Load a log file
+    static bool decode(const char* data, qint64 size, std::vector<Event>& events);  //Decode events (without the header)
+
+    static const int HEADER_SIZE = 32;      //Bytes before the first event
+    static const quint32 VERSION = 1;       //Version of the file format
+
+private:
+    Scheduler* scheduler;       //Clock of the device
+    QString path;               //Path of the log file, empty to keep the log in memory
+    QFile file;                 //The log file
+    QByteArray buffer;          //Encoded events not written yet
+    qint64 lastTime;            //Time of the previous event
+    qint64 count;               //Number of events logged
+    int depth;                  //Inputs and timers running (nested)
+    bool isOpen;                //Whether events are logged
+
+    void write(Kind kind, quint64 value);   //Encode an event at the current time
+};
+
+
+/*
+Class: EventScope
+
+Purpose: Logs an input or a timer in an EventLog for as long as it runs
+
+Usage: Make one at the start of the input or timer callback. Calls made inside it are not logged.
+       Does nothing with a nullptr log.
+*/
+
+class EventScope
+{
+public:
+    EventScope(EventLog* log, EventLog::Kind kind, quint64 value = 0) : log(log)
+    {
+        if(log != nullptr){ log->enter(kind, value); }
+    }
+
+    ~EventScope()
+    {
+        if(log != nullptr){ log->leave(); }
+    }
+
+private:
+    EventLog* log;              //Log the input or timer is in, may be nullptr
+};
+
+#endif // EVENTLOG_H
@@ -0,0 +1,124 @@
+#include "eventreplay.h"
+#include "cesdevice.h"
+#include "scheduler.h"
+
+/**
+ * Constructor for the EventReplay, nothing is loaded
+ */
+EventReplay::EventReplay()
+{
+    this->epoch = 0;
+    this->firstRecordId = 0;
+    this->divergence = -1;
+    this->simulatedTime = 0;
+    this->batteryPercentage = 100;
+}
+
+/**
+ * Loads an event log
+ *
+ * @param path is the path of the log file
+ * @return false if the file can't be read or is not an event log
+ */
+bool EventReplay::load(const QString& path)
+{
+    return EventLog::read(path, epoch, firstRecordId, events);
+}
+
+/**
+ * Replays the loaded log on a new device in virtual time and checks that the device
+ * logs exactly the same events again
+ *
+ * @return false if the replay differs from the log
+ */
+bool EventReplay::run()
+{
+    records.clear();
+    batteryPercentage = 100;
+
+    Scheduler scheduler(Scheduler::VirtualTime);
+    scheduler.setEpoch(epoch);
+
+    CESDevice device(&scheduler, this);
+    device.setNextRecordId(firstRecordId);
+
+    EventLog replayed(&scheduler);
+    replayed.open(firstRecordId);
+    device.setEventLog(&replayed);
+
+    for(const EventLog::Event& event : events){
+        scheduler.advanceTo(event.time);
+
+        switch(event.kind)
+        {
+        case EventLog::PressPower: device.pressPower(); break;
+        case EventLog::ToggleRecording: device.toggleRecording(); break;
+        case EventLog::SkinContact: device.changeSkinContact(event.value != 0); break;
+        case EventLog::DeviceEnabled: device.changeDeviceEnabled(event.value != 0); break;
+        case EventLog::PowerLevel: device.changePowerLevel((int)event.value); break;
+        case EventLog::BatteryPercentage: device.changeBatteryPercentage((int)event.value); break;
+        case EventLog::InactivityUpdate: device.inactivityUpdate(); break;
+        case EventLog::ResetInactivity: device.resetInactivity(); break;
+        case EventLog::IncreasePower: device.increasePower(); break;
+        case EventLog::DecreasePower: device.decreasePower(); break;
+        case EventLog::SelectFrequency: device.selectFrequency((int)event.value); break;
+        case EventLog::SelectWaveform: device.selectWaveform((int)event.value); break;
+        case EventLog::SelectTherapyTime: device.selectTherapyTime((int)event.value); break;
+
+        //The device's timers fire in the same order as in the logged run, the next one is this one
+        case EventLog::TherapyTimer:
+        case EventLog::BatteryTimer:
+        case EventLog::InactivityTimer:
+        case EventLog::SkinOffTimer:
+            scheduler.fireNext();
+            break;
+
+        //Checks are logged again by the inputs and timers that lead to them
+        case EventLog::BatteryChanged:
+        case EventLog::RecordSaved:
+            break;
+        }
+    }
+
+    simulatedTime = scheduler.now();
+    device.setEventLog(nullptr);
+
+    //Compare the logs event by event
+    std::vector<EventLog::Event> again;
+    EventLog::decode(replayed.getData().constData(), replayed.getData().size(), again);
+
+    divergence = -1;
+    for(size_t i = 0; i < events.size() || i < again.size(); i++){
+        if(i >= events.size() || i >= again.size() || !(events[i] == again[i])){
+            divergence = (qint64)i;
+            break;
+        }
+    }
+
+    return divergence < 0;
+}
+
+/**
+ * Keeps a record saved by the replayed device
+ * @param record is the saved record
+ */
+void EventReplay::recordSaved(const SessionRecord& record)
+{
+    records.push_back(record);
+}
+
+/**
+ * Keeps the battery percentage of the replayed device
+ * @param percentage is the new percentage
+ */
+void EventReplay::batteryChanged(int percentage)
+{
+    batteryPercentage = percentage;
+}
+
+//Getters
+qint64 EventReplay::getEventCount(){ return (qint64)events.size(); }
+qint64 EventReplay::getDivergence(){ return divergence; }
+qint64 EventReplay::getSimulatedTime(){ return simulatedTime; }
+int EventReplay::getBatteryPercentage(){ return batteryPercentage; }
+const std::vector<SessionRecord>& EventReplay::getRecords(){ return records; }
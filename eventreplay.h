@@ -0,0 +1,55 @@
+#ifndef EVENTREPLAY_H
+#define EVENTREPLAY_H
+
+#include <QString>
+#include <vector>
+
+#include "deviceobserver.h"
+#include "eventlog.h"
+#include "sessionrecord.h"
+
+/*
+Class: EventReplay
+
+Purpose: This class rebuilds a logged run of a CES device from its EventLog, as fast as the CPU allows.
+
+Usage: load() the log, then run() it:
+        - a new device is made on a virtual time clock with the calendar time and record IDs of the run
+        - every logged input is applied at its logged time, every logged timer firing fires the
+          device's next pending timer at its logged time (late if it was late)
+        - the replayed device logs itself into a log in memory, which must match the loaded one
+          event for event: the same inputs, timer firings, battery percentages and records
+       run() returns false at the first event that differs (getDivergence()).
+       The records of the replay are kept (getRecords()).
+*/
+
+class EventReplay : public DeviceObserver
+{
+public:
+    EventReplay();
+
+    bool load(const QString& path);     //Load an event log, false if it can't be read
+    bool run();                         //Replay the loaded log, false if the replay differs from it
+
+    //DeviceObserver
+    void recordSaved(const SessionRecord& record) override;
+    void batteryChanged(int percentage) override;
+
+    //Getters
+    qint64 getEventCount();                     //Number of events loaded
+    qint64 getDivergence();                     //Index of the first event the replay differs at, -1 if it matches
+    qint64 getSimulatedTime();                  //Time of the clock at the end of the replay in ms
+    int getBatteryPercentage();                 //Last battery percentage of the replay
+    const std::vector<SessionRecord>& getRecords();     //Records saved by the replay
+
+private:
+    std::vector<EventLog::Event> events;    //The loaded events
+    time_t epoch;                           //Calendar time of clock 0 of the logged run
+    int firstRecordId;                      //ID of the first record of the logged run
+    qint64 divergence;                      //Index of the first event that differs, -1 if none
+    qint64 simulatedTime;                   //Time of the clock at the end of the replay
+    int batteryPercentage;                  //Last battery percentage reported
+    std::vector<SessionRecord> records;     //Records saved by the replay
+};
+
+#endif // EVENTREPLAY_H
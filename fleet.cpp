@@ -0,0 +1,276 @@
+#include "fleet.h"
+
+//The step of the fleet relies on loop vectorization, which GCC only does fully at -O3
+//(Clang does at -O2). Only that function is built at -O3, the rest of the core keeps its level.
+#if defined(__GNUC__) && !defined(__clang__)
+#define VECTORIZED __attribute__((optimize("O3")))
+#else
+#define VECTORIZED
+#endif
+
+/**
+ * Constructor for the Fleet. Every device starts turned on, with a full battery,
+ * not treating and burning 1% every 20 seconds, like a new CESDevice.
+ *
+ * @param size is the number of devices in the fleet
+ */
+Fleet::Fleet(int size)
+    : powerLevel(size, 2), burnRate(size, 20), burnCount(size, 0), percentage(size, 100),
+      duration(size, 20), contact(size, 0), isOn(size, 1), treating(size, 0), recording(size, 0),
+      inactive(size, 0)
+{
+    deviceCount = size;
+    simulatedSeconds = 0;
+    records = 0;
+    fiveWarnings = 0;
+    twoWarnings = 0;
+}
+
+/**
+ * Deconstructor for the Fleet
+ */
+Fleet::~Fleet()
+{
+
+}
+
+/**
+ * Puts the earclips of a device on the skin and starts a default 20 minute therapy
+ * at 100uA, like CESDevice::changeSkinContact(true). Does nothing if the device is off.
+ *
+ * @param device is the index of the device
+ * @param record is true if the therapy should be recorded
+ */
+void Fleet::startTherapy(int device, bool record)
+{
+    contact[device] = 1;
+
+    if(!isOn[device] || treating[device]){ return; }
+
+    treating[device] = 1;
+    recording[device] = record ? 1 : 0;
+    inactive[device] = 0;
+    duration[device] = 20;
+    powerLevel[device] = 2;
+    burnRate[device] = 18;
+}
+
+/**
+ * Increases the power level of a device by 50uA (up to 500uA), like CESDevice::increasePower()
+ * @param device is the index of the device
+ */
+void Fleet::increasePower(int device)
+{
+    powerLevel[device] = powerLevel[device] == 10 ? 10 : powerLevel[device] + 1;
+    burnRate[device] = burnRate[device] == 10 ? 10 : burnRate[device] - 1;
+}
+
+/**
+ * Decreases the power level of a device by 100uA (down to 50uA), like CESDevice::decreasePower()
+ * @param device is the index of the device
+ */
+void Fleet::decreasePower(int device)
+{
+    powerLevel[device] = powerLevel[device] < 3 ? 1 : powerLevel[device] - 2;
+    burnRate[device] = burnRate[device] == 20 ? 20 : burnRate[device] + 2;
+}
+
+/**
+ * Advances the given columns by one simulated second.
+ * All columns are updated in one pass without branches: every rule is computed
+ * as a 0/1 (or 0x00/0xff) mask and applied with arithmetic, so the loop runs on SIMD registers.
+ * The columns never overlap, the restrict pointers tell the compiler so.
+ *
+ * @param awake is set to non zero if any device is still on after that second
+ * @param fiveWarned is increased by the number of devices that reached 5% battery
+ * @param twoWarned is increased by the number of devices that reached 2% battery
+ * @return the number of therapies recorded during that second
+ */
+VECTORIZED static unsigned int stepColumns(unsigned int& awake, unsigned int& fiveWarned, unsigned int& twoWarned, int devices, quint8* __restrict power, quint8* __restrict rate,
+                                quint8* __restrict count, quint8* __restrict percent, quint8* __restrict left,
+                                quint8* __restrict skin, quint8* __restrict on, quint8* __restrict treat,
+                                quint8* __restrict record, quint8* __restrict inactive)
+{
+    unsigned int recorded = 0;
+    unsigned int anyOn = 0;
+    unsigned int five = 0;
+    unsigned int two = 0;
+
+    for(int i = 0; i < devices; i++){
+
+        //Battery: a device that is on burns one second, every burnRate seconds it loses 1%
+        quint8 burnt = count[i] + on[i];
+        quint8 burnStep = (quint8)(burnt >= rate[i]) & on[i];
+        count[i] = burnt & (quint8)(burnStep - 1);
+        percent[i] -= burnStep & (quint8)(percent[i] > 0);
+        five += burnStep & (quint8)(percent[i] == 5);
+
+        //Inactivity: a device that is on and not treating counts a minute, after 30 it turns off
+        quint8 idle = on[i] & (quint8)(treat[i] ^ 1);
+        inactive[i] += idle;
+        quint8 asleep = idle & (quint8)(inactive[i] == 30);
+
+        //Therapy: counts down while treating with the earclips on the skin
+        quint8 running = treat[i] & skin[i] & on[i];
+        left[i] -= running;
+        quint8 finished = running & (quint8)(left[i] == 0);
+
+        //Battery at 2%: the device shuts down, ending its therapy
+        quint8 shutdown = on[i] & (quint8)(percent[i] == 2);
+        two += shutdown;
+        quint8 ended = finished | (shutdown & treat[i]);
+
+        //An ended therapy is recorded if recording was on, then the earclips come off
+        //and the device goes back to its default settings
+        recorded += ended & record[i];
+        treat[i] &= (quint8)(ended ^ 1);
+        skin[i] &= (quint8)(ended ^ 1);
+        record[i] &= (quint8)((ended | shutdown | asleep) ^ 1);
+        quint8 reset = (quint8)(0 - ended);
+        power[i] = (power[i] & (quint8)~reset) | (2 & reset);
+        rate[i] = (rate[i] & (quint8)~reset) | (20 & reset);
+        on[i] &= (quint8)((shutdown | asleep) ^ 1);
+        anyOn |= on[i];
+    }
+
+    awake = anyOn;
+    fiveWarned += five;
+    twoWarned += two;
+    return recorded;
+}
+
+/**
+ * Advances every device by one simulated second in a single vectorized pass over the columns
+ */
+void Fleet::step()
+{
+    run(1);
+}
+
+/**
+ * Advances every device by the given number of seconds
+ * @param seconds is the number of seconds to simulate
+ */
+void Fleet::run(int seconds)
+{
+    completeRun(seconds, runRange(0, deviceCount, seconds));
+}
+
+/**
+ * Advances the devices begin to end - 1 by the given number of seconds, without updating
+ * the fleet's totals. A device that is off never changes, so the range stops early once
+ * all of its devices are off. Disjoint ranges can run on different threads at the same time.
+ *
+ * @param begin is the index of the first device
+ * @param end is the index after the last device
+ * @param seconds is the number of seconds to simulate
+ * @return the number of therapies recorded and battery warnings given in the range
+ */
+Fleet::Totals Fleet::runRange(int begin, int end, int seconds)
+{
+    Totals totals = { 0, 0, 0 };
+    unsigned int awake = end > begin ? 1 : 0;
+
+    for(int second = 0; second < seconds && awake != 0; second++){
+        unsigned int five = 0;
+        unsigned int two = 0;
+        totals.records += stepColumns(awake, five, two, end - begin, &powerLevel[begin], &burnRate[begin], &burnCount[begin],
+                                &percentage[begin], &duration[begin], &contact[begin], &isOn[begin],
+                                &treating[begin], &recording[begin], &inactive[begin]);
+        totals.fiveWarnings += five;
+        totals.twoWarnings += two;
+    }
+
+    return totals;
+}
+
+/**
+ * Adds a run made of runRange() calls over the whole fleet to the fleet's totals
+ *
+ * @param seconds is the number of seconds every range was advanced by
+ * @param totals is the sum of the totals of all ranges
+ */
+void Fleet::completeRun(int seconds, const Totals& totals)
+{
+    simulatedSeconds += seconds;
+    records += totals.records;
+    fiveWarnings += totals.fiveWarnings;
+    twoWarnings += totals.twoWarnings;
+}
+
+/**
+ * Get the number of devices in the fleet
+ * @return the number of devices
+ */
+int Fleet::size(){ return deviceCount; }
+
+/**
+ * Get the number of seconds simulated so far
+ * @return the number of seconds
+ */
+qint64 Fleet::getSimulatedSeconds(){ return simulatedSeconds; }
+
+/**
+ * Get the number of therapies recorded by the whole fleet
+ * @return the number of records
+ */
+qint64 Fleet::getRecords(){ return records; }
+
+/**
+ * Get the number of 5% battery warnings given by the whole fleet
+ * @return the number of warnings
+ */
+qint64 Fleet::getFiveWarnings(){ return fiveWarnings; }
+
+/**
+ * Get the number of 2% battery warnings given by the whole fleet, every one shut its device down
+ * @return the number of warnings
+ */
+qint64 Fleet::getTwoWarnings(){ return twoWarnings; }
+
+/**
+ * Get the number of devices currently treating
+ * @return the number of treating devices
+ */
+int Fleet::countTreating()
+{
+    int total = 0;
+    for(int i = 0; i < deviceCount; i++){
+        total += treating[i];
+    }
+    return total;
+}
+
+/**
+ * Get the number of devices currently turned on
+ * @return the number of devices that are on
+ */
+int Fleet::countOn()
+{
+    int total = 0;
+    for(int i = 0; i < deviceCount; i++){
+        total += isOn[i];
+    }
+    return total;
+}
+
+/**
+ * Get the battery percentage of a device
+ * @param device is the index of the device
+ * @return the battery percentage
+ */
+int Fleet::getBatteryPercentage(int device){ return percentage[device]; }
+
+/**
+ * Get the remaining therapy duration of a device
+ * @param device is the index of the device
+ * @return the remaining duration
+ */
+int Fleet::getDuration(int device){ return duration[device]; }
+
+/**
+ * Get whether a device is treating
+ * @param device is the index of the device
+ * @return true if the device is treating
+ */
+bool Fleet::getIsTreating(int device){ return treating[device] != 0; }
@@ -0,0 +1,79 @@
+#ifndef FLEET_H
+#define FLEET_H
+
+#include <vector>
+#include <QtGlobal>
+
+/*
+Class: Fleet
+
+Purpose: This class simulates a large number of CES devices at once.
+
+Usage: Keeps the state of every device in contiguous columns (struct of arrays), one entry per device:
+        - power level, battery burn rate, burn count and percentage
+        - remaining therapy duration
+        - skin contact, power, treating and recording status
+        - inactive time
+       step() advances every device of the fleet by one simulated second in a single
+       branch free pass that the compiler vectorizes. Devices never interact, so disjoint ranges
+       of devices can be advanced separately (and on separate threads, see FleetRunner). Each device follows the same rules as a
+       CESDevice that is left alone: the battery burns 1% every burnRate seconds, the therapy
+       counts down while the earclips are on the skin, a finished therapy is recorded if recording
+       was on, and the device shuts down at 2% battery or after 30 minutes of inactivity.
+       The battery warnings a CESDevice would give (5% and 2%) are counted for the whole fleet.
+*/
+
+class Fleet
+{
+public:
+    struct Totals
+    {
+        qint64 records;         //Therapies recorded
+        qint64 fiveWarnings;    //Devices warned at 5% battery
+        qint64 twoWarnings;     //Devices warned at 2% battery (they shut down)
+    };
+
+    Fleet(int size);
+    ~Fleet();
+
+    void startTherapy(int device, bool record);     //Earclips on the skin: start a therapy with the default settings
+    void increasePower(int device);                 //Increase the power level by 50uA, burns the battery faster
+    void decreasePower(int device);                 //Decrease the power level by 100uA, burns the battery slower
+    void step();                                    //Advance every device by one simulated second
+    void run(int seconds);                          //Advance every device by the given number of seconds
+    Totals runRange(int begin, int end, int seconds);   //Advance a range of devices only, returns the therapies recorded and warnings given
+    void completeRun(int seconds, const Totals& totals);    //Add a run made of runRange() calls to the fleet's totals
+
+    //Getters
+    int size();                                     //Number of devices in the fleet
+    qint64 getSimulatedSeconds();                   //Seconds simulated so far
+    qint64 getRecords();                            //Therapies recorded by the whole fleet
+    qint64 getFiveWarnings();                       //5% battery warnings given by the whole fleet
+    qint64 getTwoWarnings();                        //2% battery warnings given by the whole fleet
+    int countTreating();                            //Number of devices currently treating
+    int countOn();                                  //Number of devices currently turned on
+    int getBatteryPercentage(int device);           //Battery percentage of a device
+    int getDuration(int device);                    //Remaining therapy duration of a device
+    bool getIsTreating(int device);                 //Whether a device is treating
+
+private:
+    int deviceCount;                    //Number of devices in the fleet
+    qint64 simulatedSeconds;            //Seconds simulated so far
+    qint64 records;                     //Therapies recorded by the whole fleet
+    qint64 fiveWarnings;                //5% battery warnings given by the whole fleet
+    qint64 twoWarnings;                 //2% battery warnings given by the whole fleet
+
+    //One column per device field, index i is device i
+    std::vector<quint8> powerLevel;     //Power level 0 - 10 (50uA per level)
+    std::vector<quint8> burnRate;       //Seconds it takes to burn 1% of the battery
+    std::vector<quint8> burnCount;      //Seconds since the last 1% was burnt
+    std::vector<quint8> percentage;     //Battery percentage
+    std::vector<quint8> duration;       //Remaining therapy duration
+    std::vector<quint8> contact;        //1 if the earclips are on the skin
+    std::vector<quint8> isOn;           //1 if the device is turned on
+    std::vector<quint8> treating;       //1 if the device is treating
+    std::vector<quint8> recording;      //1 if the therapy will be recorded
+    std::vector<quint8> inactive;       //Minutes of inactivity (one per second while not treating)
+};
+
+#endif // FLEET_H
@@ -0,0 +1,227 @@
+#include "fleetrunner.h"
+
+//Most devices run together, their columns fit in the cache of a core
+static const int MAX_CHUNK_SIZE = 16384;
+
+//Fewest chunks per worker, so a worker that is done early has chunks to steal
+static const int CHUNKS_PER_WORKER = 8;
+
+//Chunks are a whole number of these devices, so every chunk starts on a vector boundary
+static const int CHUNK_ALIGN = 64;
+
+
+/**
+ * Constructor for the FleetRunner. Splits the fleet into chunks and starts the worker threads.
+ *
+ * @param fleet is the fleet to advance
+ * @param threads is the number of worker threads, 0 uses one per core
+ */
+FleetRunner::FleetRunner(Fleet* fleet, int threads)
+{
+    this->fleet = fleet;
+    this->stolenChunks = 0;
+    this->generation = 0;
+    this->runSeconds = 0;
+    this->busyWorkers = 0;
+    this->stopping = false;
+
+    threadCount = threads > 0 ? threads : (int)std::thread::hardware_concurrency();
+    if(threadCount <= 0){
+        threadCount = 1;
+    }
+
+    //Enough chunks for every worker to have several, none larger than the cache holds
+    int wanted = threadCount * CHUNKS_PER_WORKER;
+    chunkSize = (fleet->size() + wanted - 1) / wanted;
+    chunkSize = (chunkSize + CHUNK_ALIGN - 1) / CHUNK_ALIGN * CHUNK_ALIGN;
+    if(chunkSize > MAX_CHUNK_SIZE){ chunkSize = MAX_CHUNK_SIZE; }
+    if(chunkSize < CHUNK_ALIGN){ chunkSize = CHUNK_ALIGN; }
+
+    chunkCount = (fleet->size() + chunkSize - 1) / chunkSize;
+    chunkTotals.resize(chunkCount, Fleet::Totals{ 0, 0, 0 });
+
+    for(int i = 0; i < threadCount; i++){
+        shards.push_back(new Shard());
+    }
+
+    //The calling thread is the first worker
+    for(int worker = 1; worker < threadCount; worker++){
+        workers.push_back(std::thread(&FleetRunner::workerLoop, this, worker));
+    }
+}
+
+
+/**
+ * Deconstructor for the FleetRunner, ends the worker threads
+ */
+FleetRunner::~FleetRunner()
+{
+    {
+        std::lock_guard<std::mutex> guard(runLock);
+        stopping = true;
+    }
+    runWake.notify_all();
+
+    for(std::thread& worker : workers){
+        worker.join();
+    }
+
+    for(Shard* shard : shards){
+        delete shard;
+    }
+}
+
+
+/**
+ * Advances the whole fleet by the given number of seconds on all worker threads
+ *
+ * @param seconds is the number of seconds to simulate
+ */
+void FleetRunner::run(int seconds)
+{
+    stolenChunks = 0;
+
+    //Deal out neighbouring chunks to the same shard
+    for(int chunk = 0; chunk < chunkCount; chunk++){
+        shards[(qint64)chunk * threadCount / chunkCount]->chunks.push_back(chunk);
+    }
+
+    //Wake the waiting workers, then work along with them
+    {
+        std::lock_guard<std::mutex> guard(runLock);
+        runSeconds = seconds;
+        busyWorkers = threadCount - 1;
+        generation++;
+    }
+    runWake.notify_all();
+
+    work(0, seconds);
+
+    {
+        std::unique_lock<std::mutex> guard(runLock);
+        runWake.wait(guard, [this]() { return busyWorkers == 0; });
+    }
+
+    //Add up the chunks in order so the total never depends on the threads
+    Fleet::Totals totals = { 0, 0, 0 };
+    for(int chunk = 0; chunk < chunkCount; chunk++){
+        totals.records += chunkTotals[chunk].records;
+        totals.fiveWarnings += chunkTotals[chunk].fiveWarnings;
+        totals.twoWarnings += chunkTotals[chunk].twoWarnings;
+    }
+
+    fleet->completeRun(seconds, totals);
+}
+
+
+/**
+ * Body of a worker thread: waits for the next run(), runs its share of it and reports
+ * back, until the runner is deleted
+ *
+ * @param worker is the index of the worker, 1 or higher
+ */
+void FleetRunner::workerLoop(int worker)
+{
+    qint64 done = 0;
+
+    for(;;){
+        int seconds;
+        {
+            std::unique_lock<std::mutex> guard(runLock);
+            runWake.wait(guard, [this, done]() { return stopping || generation != done; });
+            if(stopping){ return; }
+
+            done = generation;
+            seconds = runSeconds;
+        }
+
+        work(worker, seconds);
+
+        bool last;
+        {
+            std::lock_guard<std::mutex> guard(runLock);
+            last = --busyWorkers == 0;
+        }
+        if(last){
+            runWake.notify_all();
+        }
+    }
+}
+
+
+/**
+ * Runs the chunks of a worker's own shard, then steals chunks from the other
+ * shards until no chunk is left anywhere
+ *
+ * @param worker is the index of the worker (and of its shard)
+ * @param seconds is the number of seconds to advance every chunk by
+ */
+void FleetRunner::work(int worker, int seconds)
+{
+    int chunk;
+    qint64 stolen = 0;
+
+    for(int i = 0; i < threadCount; i++){
+
+        //Start with the own shard, then go around the others
+        int shard = (worker + i) % threadCount;
+
+        while(takeChunk(shard, i != 0, chunk)){
+            int begin = chunk * chunkSize;
+            int end = begin + chunkSize < fleet->size() ? begin + chunkSize : fleet->size();
+            chunkTotals[chunk] = fleet->runRange(begin, end, seconds);
+
+            if(i != 0){
+                stolen++;
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> guard(stolenLock);
+    stolenChunks += stolen;
+}
+
+
+/**
+ * Takes the next chunk of a shard
+ *
+ * @param shard is the index of the shard
+ * @param steal is true if the worker does not own the shard, it then takes from the back
+ * @param chunk is set to the chunk taken
+ * @return false if the shard has no chunk left
+ */
+bool FleetRunner::takeChunk(int shard, bool steal, int& chunk)
+{
+    std::lock_guard<std::mutex> guard(shards[shard]->lock);
+
+    std::deque<int>& chunks = shards[shard]->chunks;
+    if(chunks.empty()){ return false; }
+
+    if(steal){
+        chunk = chunks.back();
+        chunks.pop_back();
+    }else{
+        chunk = chunks.front();
+        chunks.pop_front();
+    }
+
+    return true;
+}
+
+/**
+ * Get the number of worker threads
+ * @return the number of threads
+ */
+int FleetRunner::getThreadCount(){ return threadCount; }
+
+/**
+ * Get the number of chunks the fleet is split into
+ * @return the number of chunks
+ */
+int FleetRunner::getChunkCount(){ return chunkCount; }
+
+/**
+ * Get the number of chunks that were stolen during the last run
+ * @return the number of stolen chunks
+ */
+qint64 FleetRunner::getStolenChunks(){ return stolenChunks; }
@@ -0,0 +1,70 @@
+#ifndef FLEETRUNNER_H
+#define FLEETRUNNER_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <QtGlobal>
+
+#include "fleet.h"
+
+/*
+Class: FleetRunner
+
+Purpose: This class advances a Fleet on several threads at once.
+
+Usage: - Splits the fleet into chunks of devices and gives every worker thread a shard of chunks.
+         Every worker gets several chunks (more for stealing), a chunk is at most what fits in the
+         cache of a core
+       - The worker threads are started once with the runner and wait for the next run() in between
+       - A worker that finished its own shard steals chunks from the other shards, so shards whose
+         devices stay on (treating) for long don't keep the idle workers waiting
+       - Each chunk runs all the requested seconds at once while its columns are in the cache
+       - Results are the same whatever number of threads is used: every chunk is advanced by
+         exactly one worker and the chunk totals are added up in chunk order
+*/
+
+class FleetRunner
+{
+public:
+    FleetRunner(Fleet* fleet, int threads = 0);
+    ~FleetRunner();
+
+    void run(int seconds);          //Advance the whole fleet by the given number of seconds
+
+    //Getters
+    int getThreadCount();           //Number of worker threads
+    int getChunkCount();            //Number of chunks the fleet is split into
+    qint64 getStolenChunks();       //Chunks that were run by another worker than their shard's owner during the last run
+
+private:
+    struct Shard
+    {
+        std::mutex lock;            //Guards the chunks of the shard
+        std::deque<int> chunks;     //Chunks still to run, the owner takes from the front, thieves from the back
+    };
+
+    Fleet* fleet;                   //The fleet that is advanced
+    int threadCount;                //Number of worker threads
+    int chunkCount;                 //Number of chunks the fleet is split into
+    int chunkSize;                  //Number of devices per chunk (the last one may have fewer)
+    std::vector<Shard*> shards;     //One shard of chunks per worker
+    std::vector<std::thread> workers;   //Worker threads 1 and up, the thread calling run() is worker 0
+    std::mutex runLock;             //Guards the fields below
+    std::condition_variable runWake;    //Wakes the workers for a run, and run() when they are done
+    qint64 generation;              //Number of runs started, a worker runs once per generation
+    int runSeconds;                 //Seconds of the current run
+    int busyWorkers;                //Workers 1 and up still running the current run
+    bool stopping;                  //Set to end the worker threads
+    std::vector<Fleet::Totals> chunkTotals;     //Therapies recorded and warnings given by each chunk during the last run
+    qint64 stolenChunks;            //Chunks stolen during the last run
+    std::mutex stolenLock;          //Guards stolenChunks
+
+    void workerLoop(int worker);            //Body of a worker thread: wait for a run, work, repeat
+    void work(int worker, int seconds);     //Run the chunks of a worker's shard, then steal from others
+    bool takeChunk(int shard, bool steal, int& chunk);  //Take a chunk from a shard (front for the owner, back for thieves)
+};
+
+#endif // FLEETRUNNER_H
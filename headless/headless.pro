@@ -0,0 +1,17 @@
+# Headless runner for the CES device simulation.
+# Links only QtCore, no widgets, so many devices can be simulated per process.
+
+QT       -= gui
+QT       += core
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TARGET = ces-headless
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(../ces-core.pri)
+
+SOURCES += \
+    main.cpp
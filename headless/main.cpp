@@ -0,0 +1,373 @@
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QTextStream>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "cesdevice.h"
+#include "deviceobserver.h"
+#include "eventlog.h"
+#include "eventreplay.h"
+#include "fleet.h"
+#include "fleetrunner.h"
+#include "notificationqueue.h"
+#include "scheduler.h"
+#include "trace.h"
+#include "waveformgenerator.h"
+
+/*
+Class: HeadlessObserver
+
+Purpose: Observes one simulated device in a headless run
+
+Usage: Counts the records and ended sessions of its device, and counts down the
+       number of devices of the run that are still treating. Posts the battery warnings
+       of its device to the notifications of the run.
+*/
+
+class HeadlessObserver : public DeviceObserver
+{
+public:
+    HeadlessObserver(int* remaining, NotificationQueue* notifications)
+        : remaining(remaining), notifications(notifications), records(0) {}
+
+    void recordSaved(const SessionRecord&) override { records++; }
+    void batteryWarning(int percentage) override
+    {
+        notifications->post(percentage, NotificationQueue::batteryWarning(percentage));
+    }
+    void sessionEnded() override
+    {
+        //Last device to finish ends a real time run
+        if(--(*remaining) == 0){
+            QCoreApplication::quit();
+        }
+    }
+
+    int getRecords() { return records; }
+
+private:
+    int* remaining;         //Devices of the run still treating
+    NotificationQueue* notifications;   //Warnings of every device of the run
+    int records;            //Records saved by this device
+};
+
+
+/**
+ * Prints the notifications given during a run, once per kind with the number of times it was given
+ *
+ * @param notifications is the queue of the run, emptied
+ * @param out is where they are printed
+ */
+static void printNotifications(NotificationQueue& notifications, QTextStream& out)
+{
+    NotificationQueue::Notification notification;
+    while(notifications.take(notification)){
+        out << notification.text << " x" << notification.count << "\n";
+    }
+}
+
+
+/**
+ * Runs a fleet of devices stored as columns. Every device starts a recorded therapy,
+ * then the whole fleet is advanced on the given number of threads.
+ *
+ * @param deviceCount is the number of devices in the fleet
+ * @param seconds is the number of seconds to simulate
+ * @param threads is the number of worker threads, 0 uses one per core
+ * @return the exit code of the run
+ */
+static int runFleet(int deviceCount, int seconds, int threads)
+{
+    Fleet fleet(deviceCount);
+    for(int i = 0; i < deviceCount; i++){
+        fleet.startTherapy(i, true);
+    }
+
+    QElapsedTimer wallTime;
+    wallTime.start();
+
+    FleetRunner runner(&fleet, threads);
+    runner.run(seconds);
+
+    //Throughput in simulated device seconds per wall clock second
+    qint64 elapsed = wallTime.nsecsElapsed();
+    double deviceSeconds = (double)deviceCount * seconds;
+    double throughput = elapsed > 0 ? deviceSeconds * 1e9 / elapsed : 0;
+
+    //The fleet gives the same warnings as the devices, all at once
+    NotificationQueue notifications;
+    notifications.post(5, NotificationQueue::batteryWarning(5), fleet.getFiveWarnings());
+    notifications.post(2, NotificationQueue::batteryWarning(2), fleet.getTwoWarnings());
+
+    QTextStream out(stdout);
+    printNotifications(notifications, out);
+    out << "fleet devices: " << deviceCount << ", threads: " << runner.getThreadCount()
+        << ", chunks: " << runner.getChunkCount() << ", stolen chunks: " << runner.getStolenChunks() << ", simulated seconds: " << fleet.getSimulatedSeconds()
+        << ", records: " << fleet.getRecords() << ", still on: " << fleet.countOn()
+        << ", wall ms: " << elapsed / 1000000 << ", device-seconds/s: " << (qint64)throughput << "\n";
+
+    return 0;
+}
+
+
+/**
+ * Synthesizes the output current of every waveform/frequency combination at 500uA
+ * for offline validation. Reports the RMS current and the generation speed of each.
+ *
+ * @param seconds is the length of the signal to generate for each combination
+ * @param sampleRate is the number of samples per second
+ * @return the exit code of the run
+ */
+static int runSynthesis(int seconds, int sampleRate)
+{
+    const char* waveforms[] = { "Alpha", "Beta", "Gamma" };
+    const char* frequencies[] = { "0.5Hz", "77Hz", "100Hz" };
+
+    std::vector<float> block(65536);
+    QTextStream out(stdout);
+
+    for(int waveform = 0; waveform < 3; waveform++){
+        for(int frequency = 0; frequency < 3; frequency++){
+
+            WaveformGenerator generator(sampleRate);
+            generator.configure(waveform, frequency, 10);
+
+            qint64 total = (qint64)seconds * sampleRate;
+            double squares = 0;
+
+            QElapsedTimer wallTime;
+            wallTime.start();
+
+            for(qint64 done = 0; done < total; done += (qint64)block.size()){
+                int count = total - done < (qint64)block.size() ? (int)(total - done) : (int)block.size();
+                generator.generate(block.data(), count);
+
+                for(int i = 0; i < count; i++){
+                    squares += block[i] * block[i];
+                }
+            }
+
+            qint64 elapsed = wallTime.nsecsElapsed();
+            out << waveforms[waveform] << " " << frequencies[frequency]
+                << ": rms uA: " << (total > 0 ? std::sqrt(squares / total) : 0.0)
+                << ", megasamples/s: " << (elapsed > 0 ? total * 1e3 / elapsed : 0.0) << "\n";
+        }
+    }
+
+    return 0;
+}
+
+
+/**
+ * Rebuilds a logged run of a device from its event log in virtual time and checks that
+ * the replay logs the same inputs, timer firings, battery percentages and records
+ *
+ * @param path is the path of the event log
+ * @return the exit code of the run, 1 if the log can't be read or the replay differs
+ */
+static int runReplay(const QString& path)
+{
+    QTextStream out(stdout);
+
+    EventReplay replay;
+    if(!replay.load(path)){
+        out << "can't read event log " << path << "\n";
+        return 1;
+    }
+
+    QElapsedTimer wallTime;
+    wallTime.start();
+
+    bool matches = replay.run();
+    qint64 elapsed = wallTime.nsecsElapsed();
+
+    out << "events: " << replay.getEventCount() << ", records: " << (qint64)replay.getRecords().size()
+        << ", battery: " << replay.getBatteryPercentage() << "%, simulated ms: " << replay.getSimulatedTime()
+        << ", wall us: " << elapsed / 1000 << ", "
+        << (matches ? QString("matches the log") : "differs from the log at event " + QString::number(replay.getDivergence()))
+        << "\n";
+
+    return matches ? 0 : 1;
+}
+
+
+/**
+ * Runs a number of devices without any widgets. Every device is turned on, records
+ * a default therapy session and runs it until its timer runs out.
+ * By default the devices run in virtual time and the run takes as long as the CPU needs,
+ * --realtime runs them on the wall clock instead.
+ * --fleet runs the devices as a Fleet for the given number of seconds instead,
+ * on one thread per core unless --threads is given.
+ * --synthesize generates the output current of every waveform/frequency combination for
+ * the given number of seconds instead, at --rate samples per second (48000 by default, at least 200).
+ * --events logs the inputs and timer firings of the first device to the given file,
+ * --replay rebuilds the run of a device from such a log instead (e.g. one the GUI wrote).
+ * --snapshot saves the state of the first device to the given file once the virtual clock
+ * reaches --at ms, --restore starts every device from such a snapshot instead of a new therapy.
+ * --therapy sets the length of every therapy in seconds (the selected 20 by default). The run
+ * reports the largest drift: how much longer than its length a therapy ran.
+ * Device and fleet runs print the battery warnings their devices gave, with how many gave each.
+ * CES_TRACE=FILE writes a Chrome trace of the devices' inputs, timers and state changes to FILE.
+ *
+ * Usage: ces-headless [--devices N] [--realtime] [--fleet] [--seconds S] [--threads T]
+ *                     [--synthesize S] [--rate R] [--events FILE] [--replay FILE]
+ *                     [--snapshot FILE --at MS] [--restore FILE] [--therapy S]
+ */
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    //Number of devices to simulate
+    int deviceCount = 1000;
+    QStringList args = a.arguments();
+    int devicesArg = args.indexOf("--devices");
+    if(devicesArg > 0 && devicesArg + 1 < args.size()){
+        deviceCount = args.at(devicesArg + 1).toInt();
+    }
+    if(deviceCount <= 0){ return 0; }
+
+    int replayArg = args.indexOf("--replay");
+    if(replayArg > 0 && replayArg + 1 < args.size()){
+        return runReplay(args.at(replayArg + 1));
+    }
+
+    int synthesizeArg = args.indexOf("--synthesize");
+    if(synthesizeArg > 0 && synthesizeArg + 1 < args.size()){
+        int sampleRate = 48000;
+        int rateArg = args.indexOf("--rate");
+        if(rateArg > 0 && rateArg + 1 < args.size()){
+            sampleRate = args.at(rateArg + 1).toInt();
+        }
+        if(sampleRate < WaveformKernels::MIN_SAMPLE_RATE){
+            QTextStream(stdout) << "the sample rate must be at least " << WaveformKernels::MIN_SAMPLE_RATE << "\n";
+            return 1;
+        }
+        return runSynthesis(args.at(synthesizeArg + 1).toInt(), sampleRate);
+    }
+
+    //Fleet runs last a fixed number of seconds, an hour by default
+    if(args.contains("--fleet")){
+        int seconds = 3600;
+        int secondsArg = args.indexOf("--seconds");
+        if(secondsArg > 0 && secondsArg + 1 < args.size()){
+            seconds = args.at(secondsArg + 1).toInt();
+        }
+        int threads = 0;
+        int threadsArg = args.indexOf("--threads");
+        if(threadsArg > 0 && threadsArg + 1 < args.size()){
+            threads = args.at(threadsArg + 1).toInt();
+        }
+        return runFleet(deviceCount, seconds, threads);
+    }
+    bool realTime = args.contains("--realtime");
+    Scheduler scheduler(realTime ? Scheduler::RealTime : Scheduler::VirtualTime);
+
+    QByteArray tracePath = qgetenv("CES_TRACE");
+    if(!tracePath.isEmpty() && Trace::start(QString::fromLocal8Bit(tracePath))){
+        Trace::setThreadName("devices");
+    }
+
+    //Log the first device, if asked to
+    QString eventsPath;
+    int eventsArg = args.indexOf("--events");
+    if(eventsArg > 0 && eventsArg + 1 < args.size()){
+        eventsPath = args.at(eventsArg + 1);
+    }
+    EventLog eventLog(&scheduler, eventsPath);
+
+    //Start from a snapshot, if asked to
+    DeviceSnapshot snapshot;
+    bool restore = false;
+    int restoreArg = args.indexOf("--restore");
+    if(restoreArg > 0 && restoreArg + 1 < args.size()){
+        if(!snapshot.load(args.at(restoreArg + 1))){
+            QTextStream(stdout) << "can't read snapshot " << args.at(restoreArg + 1) << "\n";
+            return 1;
+        }
+        restore = true;
+    }
+
+    //Length of every therapy, if not the default
+    int therapySeconds = 0;
+    int therapyArg = args.indexOf("--therapy");
+    if(therapyArg > 0 && therapyArg + 1 < args.size()){
+        therapySeconds = args.at(therapyArg + 1).toInt();
+    }
+
+    int remaining = deviceCount;
+    NotificationQueue notifications;
+    std::vector<HeadlessObserver*> observers;
+    std::vector<CESDevice*> devices;
+
+    //Create the devices, record and start a therapy on each of them
+    for(int i = 0; i < deviceCount; i++){
+        observers.push_back(new HeadlessObserver(&remaining, &notifications));
+        devices.push_back(new CESDevice(&scheduler, observers.back()));
+
+        if(i == 0 && !eventsPath.isEmpty() && eventLog.open(devices.back()->getNextRecordId())){
+            devices.back()->setEventLog(&eventLog);
+        }
+
+        if(restore){
+            devices.back()->restoreSnapshot(snapshot);
+            continue;
+        }
+
+        if(therapySeconds > 0){
+            devices.back()->getCurrSession()->setLastDuration(therapySeconds);
+        }
+
+        devices.back()->toggleRecording();
+        devices.back()->changeSkinContact(true);
+    }
+
+    QElapsedTimer wallTime;
+    wallTime.start();
+
+    //Run until every session ended
+    int result = 0;
+    if(realTime){
+        result = a.exec();
+    }else{
+        //Save the first device once the clock reaches --at
+        int snapshotArg = args.indexOf("--snapshot");
+        int atArg = args.indexOf("--at");
+        if(snapshotArg > 0 && snapshotArg + 1 < args.size() && atArg > 0 && atArg + 1 < args.size()){
+            scheduler.runUntil(args.at(atArg + 1).toInt());
+            if(!devices[0]->saveSnapshot().save(args.at(snapshotArg + 1))){
+                result = 1;
+            }
+        }
+
+        while(remaining > 0 && scheduler.runNext()){}
+    }
+
+    //Report the run
+    int records = 0;
+    for(HeadlessObserver* observer : observers){
+        records += observer->getRecords();
+    }
+
+    qint64 drift = 0;
+    for(CESDevice* device : devices){
+        drift = std::max(drift, device->getCurrSession()->getDrift());
+    }
+
+    QTextStream out(stdout);
+    printNotifications(notifications, out);
+    out << "devices: " << deviceCount << ", records: " << records
+        << ", simulated ms: " << scheduler.now() << ", wall ms: " << wallTime.elapsed()
+        << ", max therapy drift us: " << drift / 1000 << "\n";
+
+    eventLog.close();
+    for(int i = 0; i < deviceCount; i++){
+        delete devices[i];
+        delete observers[i];
+    }
+
+    Trace::stop();
+    return result;
+}
@@ -0,0 +1,115 @@
+#include "latencyhistogram.h"
+
+#include <algorithm>
+
+/**
+ * Constructor for the LatencyHistogram, makes every bucket up front
+ */
+LatencyHistogram::LatencyHistogram()
+{
+    counts.assign(indexOf(MAX_VALUE) + 1, 0);
+    reset();
+}
+
+/**
+ * Deconstructor for the LatencyHistogram
+ */
+LatencyHistogram::~LatencyHistogram()
+{
+
+}
+
+/**
+ * Bucket of a value. Values below SUB_BUCKETS are their own bucket. Above, the value is
+ * shifted right until its top SUB_BUCKET_BITS bits are left: the shift picks the power of two
+ * and the bits left pick one of its HALF_BUCKETS buckets.
+ *
+ * @param value is 0 - MAX_VALUE
+ * @return the index of its bucket
+ */
+int LatencyHistogram::indexOf(qint64 value)
+{
+    if(value < SUB_BUCKETS){ return (int)value; }
+
+    int magnitude = 0;
+    while((value >> magnitude) >= SUB_BUCKETS){ magnitude++; }
+
+    return (magnitude + 1) * HALF_BUCKETS + (int)(value >> magnitude) - HALF_BUCKETS;
+}
+
+/**
+ * Largest value of a bucket
+ *
+ * @param index is the index of the bucket
+ * @return the largest value that falls in it
+ */
+qint64 LatencyHistogram::highestAt(int index)
+{
+    if(index < SUB_BUCKETS){ return index; }
+
+    int magnitude = index / HALF_BUCKETS - 1;
+    qint64 subBucket = index % HALF_BUCKETS + HALF_BUCKETS;
+    return ((subBucket + 1) << magnitude) - 1;
+}
+
+/**
+ * Counts a duration
+ *
+ * @param nanoseconds is the duration, negative ones count as 0 and ones above MAX_VALUE as MAX_VALUE
+ */
+void LatencyHistogram::record(qint64 nanoseconds)
+{
+    if(nanoseconds < 0){ nanoseconds = 0; }
+    if(nanoseconds > MAX_VALUE){ nanoseconds = MAX_VALUE; }
+
+    counts[indexOf(nanoseconds)]++;
+    count++;
+    total += nanoseconds;
+    if(nanoseconds < min){ min = nanoseconds; }
+    if(nanoseconds > max){ max = nanoseconds; }
+}
+
+/**
+ * Forgets every value recorded
+ */
+void LatencyHistogram::reset()
+{
+    std::fill(counts.begin(), counts.end(), 0);
+    count = 0;
+    total = 0;
+    min = MAX_VALUE;
+    max = 0;
+}
+
+/**
+ * Value that a percentage of the recorded values are at or below
+ *
+ * @param percentile is 0 - 100
+ * @return the highest value of the bucket holding that value (at most the largest value recorded), 0 if nothing was recorded
+ */
+qint64 LatencyHistogram::percentile(double percentile)
+{
+    if(count == 0){ return 0; }
+
+    //Number of values at or below the result, at least one
+    qint64 target = (qint64)(percentile / 100.0 * count + 0.5);
+    if(target < 1){ target = 1; }
+    if(target > count){ target = count; }
+
+    qint64 seen = 0;
+    for(size_t i = 0; i < counts.size(); i++){
+        seen += counts[i];
+        if(seen >= target){
+            qint64 highest = highestAt((int)i);
+            return highest < max ? highest : max;
+        }
+    }
+
+    return max;
+}
+
+//Getters
+qint64 LatencyHistogram::getCount(){ return count; }
+qint64 LatencyHistogram::getMin(){ return count > 0 ? min : 0; }
+qint64 LatencyHistogram::getMax(){ return max; }
+double LatencyHistogram::getMean(){ return count > 0 ? (double)total / count : 0.0; }
@@ -0,0 +1,83 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <QElapsedTimer>
+#include <QtGlobal>
+#include <vector>
+
+/*
+Class: LatencyHistogram
+
+Purpose: This class counts durations (in ns) in a high dynamic range histogram.
+
+Usage: Counts durations from 1ns to an hour in log-linear buckets, the way HdrHistogram does:
+        - values below 256ns have a bucket each
+        - above that, each power of two is split into 128 buckets, so every bucket is within
+          0.8% of the values it counts, whatever their size
+       record() is O(1) and never allocates (the buckets are made with the histogram), so it can
+       sit on the hot path. percentile() reports the highest value of the bucket holding the
+       percentile, at most the largest value recorded.
+*/
+
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+    ~LatencyHistogram();
+
+    void record(qint64 nanoseconds);        //Count a duration, negative ones count as 0
+    void reset();                           //Forget every value recorded
+
+    //Getters
+    qint64 getCount();                      //Number of values recorded
+    qint64 getMin();                        //Smallest value recorded in ns, 0 if none
+    qint64 getMax();                        //Largest value recorded in ns, 0 if none
+    double getMean();                       //Average of the values recorded in ns, 0 if none
+    qint64 percentile(double percentile);   //Value in ns that percentile % (0 - 100) of the values are at or below
+
+    static const qint64 MAX_VALUE = 3600000000000LL;    //Largest value counted (an hour), larger ones count as it
+
+private:
+    static const int SUB_BUCKET_BITS = 8;                       //Bits of a value kept exactly
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;        //Buckets below the first power of two that is split
+    static const int HALF_BUCKETS = SUB_BUCKETS / 2;            //Buckets each power of two above that is split into
+
+    std::vector<quint32> counts;    //Number of values in each bucket
+    qint64 count;                   //Number of values recorded
+    qint64 total;                   //Sum of the values recorded (ns)
+    qint64 min;                     //Smallest value recorded
+    qint64 max;                     //Largest value recorded
+
+    static int indexOf(qint64 value);       //Bucket of a value
+    static qint64 highestAt(int index);     //Largest value of a bucket
+};
+
+
+/*
+Class: LatencyScope
+
+Purpose: Records how long a block of code takes into a LatencyHistogram
+
+Usage: Make one at the start of the block, it records the time when it goes out of scope
+       (whichever way the block is left). Does nothing with a nullptr histogram.
+*/
+
+class LatencyScope
+{
+public:
+    LatencyScope(LatencyHistogram* histogram) : histogram(histogram)
+    {
+        if(histogram != nullptr){ timer.start(); }
+    }
+
+    ~LatencyScope()
+    {
+        if(histogram != nullptr){ histogram->record(timer.nsecsElapsed()); }
+    }
+
+private:
+    LatencyHistogram* histogram;    //Receives the time of the block, may be nullptr
+    QElapsedTimer timer;            //Started when the block was entered
+};
+
+#endif // LATENCYHISTOGRAM_H
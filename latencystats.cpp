@@ -0,0 +1,121 @@
+#include "latencystats.h"
+
+#include <QFile>
+#include <QTextStream>
+
+//Width of the name column of the report
+static const int NAME_WIDTH = 24;
+
+//Width of a number column of the report
+static const int NUMBER_WIDTH = 10;
+
+
+/**
+ * Text right aligned in a column of the report, with a space before it even if it is too wide
+ *
+ * @param text is the text of the column
+ * @return the text of the column, at least NUMBER_WIDTH wide
+ */
+static QString column(const QString& text)
+{
+    return " " + text.rightJustified(NUMBER_WIDTH - 1);
+}
+
+/**
+ * Text of a duration in us with one decimal, right aligned in a column of the report
+ *
+ * @param nanoseconds is the duration
+ * @return the text of the column
+ */
+static QString column(qint64 nanoseconds)
+{
+    return column(QString::number(nanoseconds / 1000.0, 'f', 1));
+}
+
+
+/**
+ * Constructor for the LatencyStats, starts without any histogram
+ */
+LatencyStats::LatencyStats()
+{
+
+}
+
+/**
+ * Deconstructor for the LatencyStats, deletes the histograms
+ */
+LatencyStats::~LatencyStats()
+{
+    for(LatencyHistogram* histogram : histograms){
+        delete histogram;
+    }
+}
+
+/**
+ * Histogram of a name, made the first time the name is asked for
+ *
+ * @param name is what the histogram measures
+ * @return the histogram, owned by the stats
+ */
+LatencyHistogram* LatencyStats::histogram(const QString& name)
+{
+    QHash<QString, int>::const_iterator found = indexes.constFind(name);
+    if(found != indexes.constEnd()){
+        return histograms[found.value()];
+    }
+
+    indexes.insert(name, (int)histograms.size());
+    names.push_back(name);
+    histograms.push_back(new LatencyHistogram());
+    return histograms.back();
+}
+
+/**
+ * Percentiles of every histogram, one line each, in the order they were made
+ *
+ * @return the report, times in us
+ */
+QString LatencyStats::report()
+{
+    QString text = QString("name").leftJustified(NAME_WIDTH) + column(QString("count")) + column(QString("p50"))
+            + column(QString("p90")) + column(QString("p99")) + column(QString("p99.9")) + column(QString("max")) + "\n";
+
+    for(size_t i = 0; i < histograms.size(); i++){
+        LatencyHistogram* histogram = histograms[i];
+
+        text += names[i].leftJustified(NAME_WIDTH) + column(QString::number(histogram->getCount()))
+                + column(histogram->percentile(50)) + column(histogram->percentile(90))
+                + column(histogram->percentile(99)) + column(histogram->percentile(99.9))
+                + column(histogram->getMax()) + "\n";
+    }
+
+    return text;
+}
+
+/**
+ * Writes the report to a file, replacing it
+ *
+ * @param path is the file to write
+ * @return false if the file could not be written
+ */
+bool LatencyStats::dump(const QString& path)
+{
+    QFile file(path);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)){
+        return false;
+    }
+
+    QTextStream out(&file);
+    out << "Latency in us\n" << report();
+    return true;
+}
+
+/**
+ * Forgets every value recorded, the histograms stay
+ */
+void LatencyStats::reset()
+{
+    for(LatencyHistogram* histogram : histograms){
+        histogram->reset();
+    }
+}
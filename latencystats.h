@@ -0,0 +1,42 @@
+#ifndef LATENCYSTATS_H
+#define LATENCYSTATS_H
+
+#include <QHash>
+#include <QString>
+#include <vector>
+
+#include "latencyhistogram.h"
+
+/*
+Class: LatencyStats
+
+Purpose: This class keeps the named latency histograms of the device and reports their percentiles.
+
+Usage: histogram() returns the histogram of a name, made the first time the name is asked for.
+       Look a histogram up once and keep the pointer where it is recorded often.
+       The names say what is measured:
+        - "late <timer>": how long after its deadline a timer fired
+        - "run <timer>": how long the callback of a timer ran
+        - "slot <slot>": how long a slot of the window ran
+       report() gives one line per histogram (count, p50, p90, p99, p99.9 and max in us), in the
+       order they were made. dump() writes the report to a file.
+*/
+
+class LatencyStats
+{
+public:
+    LatencyStats();
+    ~LatencyStats();
+
+    LatencyHistogram* histogram(const QString& name);   //Histogram of a name, made on first use
+    QString report();                                   //Percentiles of every histogram as a text table
+    bool dump(const QString& path);                     //Write the report to a file
+    void reset();                                       //Forget every value recorded
+
+private:
+    std::vector<QString> names;                     //Name of each histogram, in the order they were made
+    std::vector<LatencyHistogram*> histograms;      //The histograms, same order
+    QHash<QString, int> indexes;                    //Index of each name
+};
+
+#endif // LATENCYSTATS_H
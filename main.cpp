@@ -1,11 +1,25 @@
 #include "mainwindow.h"
+#include "trace.h"
 
 #include <QApplication>
 
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
-    MainWindow w;
-    w.show();
-    return a.exec();
+
+    //CES_TRACE=FILE writes a Chrome trace of the run to FILE
+    QByteArray tracePath = qgetenv("CES_TRACE");
+    if(!tracePath.isEmpty() && Trace::start(QString::fromLocal8Bit(tracePath))){
+        Trace::setThreadName("GUI");
+    }
+
+    int result;
+    {
+        MainWindow w;
+        w.show();
+        result = a.exec();
+    }
+
+    Trace::stop();
+    return result;
 }
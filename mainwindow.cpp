@@ -1,12 +1,39 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
-#include <QMessageBox>
+#include "displaytext.h"
+#include "trace.h"
+#include <QDate>
+#include <QDir>
+#include <QSignalBlocker>
+#include <QStandardPaths>
+
+//Name of the latency histogram of each slot, indexed by SlotIndex
+static const char* SLOT_NAMES[] = {
+    "slot powerClick",
+    "slot recordClick",
+    "slot downClick",
+    "slot upClick",
+    "slot selectClick",
+    "slot returnClick",
+    "slot powerLevelAdminChange",
+    "slot skinContactAdminChange",
+    "slot deviceEnabledChange",
+    "slot adminBatteryUpdate",
+    "slot speedChange",
+    "slot inactivityUpdate",
+    "slot resetInactivity",
+    "slot turnOnDevice",
+    "slot turnOffDevice"
+};
+
+//Time a warning stays in the status bar before the next one is shown, in ms of the wall clock
+static const int NOTIFICATION_MS = 5000;
 
 
 
 /**
  * Constructor for MainWindow class.
- * Initializes device/admin settings, timers, connects buttons and slots to tabs
+ * Initializes device/admin settings, connects buttons and slots to tabs
  *
  * @param parent is the QWidget parent of the MainWindow class
  */
@@ -16,41 +43,74 @@ MainWindow::MainWindow(QWidget *parent)
 {
     ui->setupUi(this);
 
-    //Initialize the device
-    device = new CESDevice(ui->therapyTimer, ui->recordsList);
+    //Nothing reported by the device waits to be displayed yet
+    batteryPercentage = 100;
+    inactiveSeconds = -1;
+    timerTextChanged = false;
+    batteryPercentageChanged = false;
 
-    //Connect device's timer timeout to resetting the window
-    connect(device->getCurrSession()->getInternalClock()->getTimer(),
-            &QTimer::timeout,
-            this,
-            &MainWindow::resetUI);
+    //Warnings wait here until a frame shows them, so giving one never blocks the device's timers
+    notifications = new NotificationQueue();
 
-    //Create timer used for checking battery life and connect it to slot function
-    batteryTimer = new QTimer(this);
-    batteryTimer->setTimerType(Qt::PreciseTimer);
-    connect(batteryTimer, SIGNAL(timeout()), this, SLOT(batteryUpdate()));
+    //Measure how late the timers fire and how long they and the slots run, from the start
+    latencyStats = new LatencyStats();
 
-    //Create timer used for checking inactivity on the device and connect it to slot function
-    inactivityTimer = new QTimer(this);
-    inactivityTimer->setTimerType(Qt::PreciseTimer);
-    connect(inactivityTimer, SIGNAL(timeout()), this, SLOT(inactivityUpdate()));
+    //The slots record into their histograms directly, looked up once here
+    for(int slot = 0; slot < SLOTS; slot++){
+        slotTimes[slot] = latencyStats->histogram(SLOT_NAMES[slot]);
+    }
+
+    //Initialize the device on a real time clock, the window displays everything it reports
+    scheduler = new Scheduler(Scheduler::RealTime);
+    device = new CESDevice(scheduler, this);
+    device->setLatencyStats(latencyStats);
+
+    //Produce the output current on its own thread, so nothing on this thread can glitch it
+    output = new OutputThread();
+    device->setOutput(output);
+    output->start();
+
+    //Show the underruns and deadline misses of the output and the latency percentiles in the admin area every second
+    //of the wall clock (whatever the speed of the device's clock), and write the logged events out
+    outputStatusTimer = new QTimer(this);
+    connect(outputStatusTimer, &QTimer::timeout, [this]() { showOutputStatus(); showLatency(); eventLog->flush(); });
+    outputStatusTimer->start(1000);
+
+    //Show the latest therapy timer, battery and inactivity values once per frame (60Hz)
+    displayTimer = new QTimer(this);
+    connect(displayTimer, &QTimer::timeout, [this]() { showDisplay(); });
+    displayTimer->start(16);
+
+    //Keep the recorded sessions in a binary log, mapped so startup doesn't depend on its size
+    QString dataPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dataPath);
+    recordStore = new RecordStore(QDir(dataPath).filePath("records.log"));
+    if(recordStore->open()){
+        device->setRecordStore(recordStore);
+    }
 
-    //Create timer used for checking for loss of skin contact and connect it to slot function
-    skinOffTimer = new QTimer(this);
-    skinOffTimer->setTimerType(Qt::PreciseTimer);
-    skinOffTimer->setSingleShot(true);
-    connect(skinOffTimer, SIGNAL(timeout()), this, SLOT(skinContactUpdate()));
+    //Keep per-day and per-week usage totals next to the log, caught up with any records they miss
+    usageRollups = new UsageRollups(QDir(dataPath).filePath("records.log.rollups"));
+    usageRollups->open(recordStore);
+    device->setUsageRollups(usageRollups);
+    showUsage();
+
+    //Log every input and timer of the device from here on, so the run can be rebuilt with ces-headless --replay
+    eventLog = new EventLog(scheduler, QDir(dataPath).filePath("events.log"));
+    if(eventLog->open(device->getNextRecordId())){
+        device->setEventLog(eventLog);
+    }
+
+    //Show the records newest first, rows are only formatted when they are painted
+    recordModel = new RecordListModel(recordStore, this);
+    ui->recordsList->setModel(recordModel);
 
     //Set intial time for large timer to "00:00"
-    ui->therapyTimer->display(QTime(0,0,0).toString("mm:ss"));
+    ui->therapyTimer->display(DisplayText::clock(0));
 
     //Set inactivity timer to zero and display it
     resetInactivity();
 
-    //Start battery and inactivity timers
-    batteryTimer->start(1000);
-    inactivityTimer->start(1000);
-
     //Connect buttons on the device
     connect(ui->powerButton, SIGNAL(clicked(bool)), this, SLOT(powerClick()));
     connect(ui->recordButton, SIGNAL(clicked(bool)), this, SLOT(recordClick()));
@@ -68,6 +128,7 @@ MainWindow::MainWindow(QWidget *parent)
     connect(ui->deviceEnabledValue, SIGNAL(currentIndexChanged(int)), this, SLOT(deviceEnabledChange(int)));
     connect(ui->batteryPercentageValue, SIGNAL(valueChanged(int)), this, SLOT(adminBatteryUpdate(int)));
     connect(ui->increaseInactiveTime, SIGNAL(clicked(bool)), this, SLOT(inactivityUpdate()));
+    connect(ui->speedValue, SIGNAL(currentIndexChanged(int)), this, SLOT(speedChange(int)));
 
 
 
@@ -78,86 +139,110 @@ MainWindow::MainWindow(QWidget *parent)
  */
 MainWindow::~MainWindow()
 {
-    delete ui;
+    //Keep the latency percentiles of the run next to the records
+    QString dataPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    latencyStats->dump(QDir(dataPath).filePath("latency.txt"));
+
+    delete outputStatusTimer;
+    delete displayTimer;
     delete device;
+    delete eventLog;
+    ui->recordsList->setModel(nullptr);
+    delete recordModel;
+    usageRollups->save();
+    delete usageRollups;
+    delete recordStore;
+    delete output;
+    delete scheduler;
+    delete latencyStats;
+    delete notifications;
+    delete ui;
 }
 
 
 
 /**
- * Triggered when user presses the power button on the device
+ * Displays the underruns and deadline misses of the output thread in the admin area
  */
-void MainWindow::powerClick()
+void MainWindow::showOutputStatus()
 {
-
-    //If device is on, turn it off
-    if(device->getIsOn()){
-
-        device->setIsOn(false);
-
-        //Don't burn battery or check inactivity when device is off
-        batteryTimer->stop();
-        inactivityTimer->stop();
-        resetInactivity();
-
-        //If session was in progress, end it. Will record it if that setting was chosen
-        if(device->getIsTreating()){
-            device->stopSession(device->getCurrSession()->getLastDuration() - device->getCurrSession()->getDuration());
-            ui->contactSkinValue->setCurrentIndex(1);
-            ui->timerOnLabel->setStyleSheet("color: rgb(211, 215, 207);");
-        }
-
-        //Turn off device ui/buttons
-        turnOffDevice();
+    ui->outputStatusValue->setText(QString::number(output->getUnderruns()) + " / " + QString::number(output->getDeadlineMisses()));
+}
 
 
-    //Device is off and user is turning it on
-    }else{
+/**
+ * Displays the latency percentiles of the timers and slots in the admin area
+ */
+void MainWindow::showLatency()
+{
+    ui->latencyView->setPlainText(latencyStats->report());
+}
 
-        //If battery percent is above 2 and the device is not disabled it can be turned on
-        if(device->getBattery()->getBatteryPercentage() > 2 && !device->getIsDisabled()){
 
-            //Set device to turned on
-            device->setIsOn(true);
+/**
+ * Displays the therapy timer and battery values the device reported since the last frame
+ * (only the latest of each), so a fast clock doesn't redraw them more often than the screen can show.
+ * The inactive time is worked out from the device's clock, and only while it can be seen.
+ * Pending warnings are shown one at a time in the status bar, the next one once it is free.
+ */
+void MainWindow::showDisplay()
+{
+    if(timerTextChanged){
+        ui->therapyTimer->display(timerText);
+        timerTextChanged = false;
+    }
 
-            //Turn on device ui/buttons
-            turnOnDevice();
+    if(batteryPercentageChanged){
+        ui->batteryLevelBar->setValue(batteryPercentage);
 
-            //Set the onscreen battery level and start battery timer
-            ui->batteryLevelBar->setValue(device->getBattery()->getBatteryPercentage());
-            batteryTimer->start(1000);
+        QSignalBlocker blocker(ui->batteryPercentageValue);
+        ui->batteryPercentageValue->setValue(batteryPercentage);
+        batteryPercentageChanged = false;
+    }
 
-            //start timing for inactivity
-            inactivityTimer->start(1000);
-            resetInactivity();
+    if(ui->inactivityTimer->isVisible() && !isMinimized()){
+        int seconds = device->getInactiveSeconds();
+        if(seconds != inactiveSeconds){
+            ui->inactivityTimer->display(DisplayText::clock(seconds));
+            inactiveSeconds = seconds;
+        }
+    }
 
-            //If device is contacting skin, start therapy right away
-            if(device->getContact()){
+    NotificationQueue::Notification notification;
+    if(ui->statusbar->currentMessage().isEmpty() && notifications->take(notification)){
+        QString text = notification.text;
+        if(notification.count > 1){
+            text += " (x" + QString::number(notification.count) + ")";
+        }
+        ui->statusbar->showMessage(text, NOTIFICATION_MS);
+    }
+}
 
-                //Set device for treatment mode
-                device->setIsTreating(true);
-                ui->notTreatingLabel->setText("Treating");
 
-                //Use duration that was selected last time device was on
-                device->getCurrSession()->setDuration(device->getCurrSession()->getLastDuration());
+/**
+ * Displays the number of sessions and minutes treated today and this week in the admin area
+ */
+void MainWindow::showUsage()
+{
+    qint64 today = QDate::currentDate().toJulianDay();
+    UsageTotals day = usageRollups->day(today);
+    UsageTotals week = usageRollups->week(today);
 
-                //Update the displayed time and show timer on
-                int sessionDuration = device->getCurrSession()->getDuration();
-                QTime time = QTime(0,0,0).addSecs(sessionDuration * 60);
-                QString minuteSeconds = time.toString("mm:ss");
-                ui->therapyTimer->display(sessionDuration < 60 ? minuteSeconds : QString::number(sessionDuration) + ":00");
-                ui->timerOnLabel->setStyleSheet(QString::fromUtf8("color: rgb(0,0,0);"));
+    ui->usageValue->setText(QString::number(day.sessions) + " (" + QString::number(day.minutes) + " min) / "
+                            + QString::number(week.sessions) + " (" + QString::number(week.minutes) + " min)");
+}
 
-                device->getCurrSession()->setLastPowerLevel(2);
-                ui->powerLevelAdminValue->setValue(100);
-                ui->powerLevelBar->setValue(2);
 
-                //Start the therapy
-                device->getCurrSession()->startSession();
-            }
+/**
+ * Triggered when user presses the power button on the device
+ */
+void MainWindow::powerClick()
+{
+    LatencyScope timing(slotTimes[PowerClickSlot]);
+    TraceScope trace("powerClick", "slot");
 
-        }
-    }
+    //Turns the device on or off, the device reports the changes back to the window
+    device->pressPower();
 }
 
 
@@ -166,20 +251,18 @@ void MainWindow::powerClick()
  */
 void MainWindow::recordClick()
 {
+    LatencyScope timing(slotTimes[RecordClickSlot]);
+    TraceScope trace("recordClick", "slot");
+
     //Reset inactivity count
     resetInactivity();
 
     //Get which screen is being viewed
     int curTab = ui->screenTabs->currentIndex();
 
-    //If on the therapy screen
+    //If on the therapy screen, turn on or off recording
     if(curTab == 1){
-
-        //Turn on or off recording
-        device->setRecording(!device->getRecording());
-
-        //Set on screen label to recording or not recording
-        ui->recordingLabel->setText(device->getRecording() ? "Recording" : "Not Recording");
+        device->toggleRecording();
      }
 }
 
@@ -189,6 +272,9 @@ void MainWindow::recordClick()
  */
 void MainWindow::downClick()
 {
+    LatencyScope timing(slotTimes[DownClickSlot]);
+    TraceScope trace("downClick", "slot");
+
     //Reset inactivity count
     resetInactivity();
 
@@ -228,14 +314,8 @@ void MainWindow::downClick()
 
         //Device is treating, can change power level
         }else{
-            //Decrease power by 100 mU
+            //Decrease power by 100 mU, the device updates the displayed power level
             device->decreasePower();
-
-            //Update displayed power level on device and in admin area
-            int newPowerLevel = ui->powerLevelBar->value() - 2 < 0 ? 0 : ui->powerLevelBar->value()-2;
-
-            ui->powerLevelBar->setValue(newPowerLevel);
-            ui->powerLevelAdminValue->setValue(newPowerLevel * 50);
         }
 
     //On the records page, scrolls down to the bottom of the list of records
@@ -250,6 +330,9 @@ void MainWindow::downClick()
  */
 void MainWindow::upClick()
 {
+    LatencyScope timing(slotTimes[UpClickSlot]);
+    TraceScope trace("upClick", "slot");
+
     //Reset inactivity count
     resetInactivity();
 
@@ -289,14 +372,8 @@ void MainWindow::upClick()
             }
         //Device is treating, can change power level
         }else{
-            //Increase power by 50 mU
+            //Increase power by 50 mU, the device updates the displayed power level
             device->increasePower();
-
-            //Update displayed power level on device and in admin
-            int newPowerLevel = ui->powerLevelBar->value() == 10 ? 10 : ui->powerLevelBar->value()+1;
-
-            ui->powerLevelBar->setValue(newPowerLevel);
-            ui->powerLevelAdminValue->setValue(newPowerLevel * 50);
         }
 
     //On the records page, scrolls up to the top of the list of records
@@ -311,6 +388,9 @@ void MainWindow::upClick()
  */
 void MainWindow::selectClick()
 {
+    LatencyScope timing(slotTimes[SelectClickSlot]);
+    TraceScope trace("selectClick", "slot");
+
     //Reset inactivity count
     resetInactivity();
 
@@ -419,6 +499,9 @@ void MainWindow::selectClick()
  */
 void MainWindow::returnClick()
 {
+    LatencyScope timing(slotTimes[ReturnClickSlot]);
+    TraceScope trace("returnClick", "slot");
+
     //Reset inactivity count
     resetInactivity();
 
@@ -471,45 +554,16 @@ void MainWindow::returnClick()
     }
 }
 
-/**
- * When the Session ends, update the UI to reflect this
- */
-void MainWindow::resetUI()
-{
-    //Ignore if the system is still running
-    if(device->getCurrSession()->getDuration() != 0) { return; }
-
-    ui->recordingLabel->setText("Not Recording");
-    device->setRecording(false);
-
-    ui->notTreatingLabel->setText("Not Treating");
-
-    ui->powerLevelBar->setValue(2);
-    ui->powerLevelAdminValue->setValue(100);
-
-    ui->contactSkinValue->setCurrentIndex(1);
-    ui->skinLabel->setText("Contact Off");
-
-    ui->timerOnLabel->setStyleSheet(QString::fromUtf8("color: rgb(238,238,236);"));
-
-}
-
 /**
  * Triggered when user changes the power level uA using the selector in the admin
  * @param level is the new uA of the device
  */
 void MainWindow::powerLevelAdminChange(int level)
 {
-    //Increase/decrease power level bar between 0-500 uA
-    if(level <= 500){
-        device->getCurrSession()->setLastPowerLevel(level/50);
-        ui->powerLevelBar->setValue(level/50);
-    }
+    LatencyScope timing(slotTimes[PowerLevelAdminChangeSlot]);
+    TraceScope trace("powerLevelAdminChange", "slot");
 
-    //When maximum uA for device is exceeded
-    if(level > 700){
-        ui->deviceEnabledValue->setCurrentIndex(1);
-    }
+    device->changePowerLevel(level);
 }
 
 /**
@@ -518,74 +572,10 @@ void MainWindow::powerLevelAdminChange(int level)
  */
 void MainWindow::skinContactAdminChange(int value)
 {
-    //Skin contact is true
-    if(value == 0){
-
-        //Change device skin contact to true
-        device->setContact(true);
-        ui->skinLabel->setText("Contact On");
+    LatencyScope timing(slotTimes[SkinContactAdminChangeSlot]);
+    TraceScope trace("skinContactAdminChange", "slot");
 
-        //Start treating if device is turned on
-        if(device->getIsOn()){
-
-            //If therapy was already in session and was paused by skin contact change to off,
-            //resume that session
-            if(device->getIsTreating()){
-                device->getCurrSession()->resumeSession();
-            }
-
-            //Start a new therapy
-            else{
-
-                //Set device for the treatment
-                device->setIsTreating(true);
-                ui->notTreatingLabel->setText("Treating");
-                ui->timerOnLabel->setStyleSheet(QString::fromUtf8("color: rgb(0,0,0);"));
-
-                //Reset inactivity timer to zero when treating
-                resetInactivity();
-
-                //Start the session
-                device->getCurrSession()->startSession();
-
-                //Display intial therapy duration
-                int sessionDuration = device->getCurrSession()->getDuration();
-                QTime time = QTime(0,0,0).addSecs(sessionDuration * 60);
-                QString minuteSeconds = time.toString("mm:ss");
-                ui->therapyTimer->display(sessionDuration < 60 ? minuteSeconds : QString::number(sessionDuration)+":00");
-
-                //Set onscreen/admin power level to 1
-                ui->powerLevelBar->setValue(2);
-                ui->powerLevelAdminValue->setValue(100);
-
-                //Set the battery burn rate to 1% every 12 seconds
-                device->getBattery()->intialTherapyBurnRate();
-            }
-        }
-
-    //Skin contact is changed to false
-    }else{
-
-        //Set skin contact on device/screen to off
-        device->setContact(false);
-        ui->skinLabel->setText("Contact Off");
-
-        //If device was in a therapy session, pause it and
-        //start 5 second timeout
-        if(device->getIsTreating()){
-            device->getCurrSession()->pauseSession();
-            skinOffTimer->start(5000);
-
-        //Otherwise device is not setup for treatment
-        }else{
-
-            device->setIsTreating(false);
-            ui->notTreatingLabel->setText("Not Treating");
-
-            device->getBattery()->defaultBurnRate();
-            ui->timerOnLabel->setStyleSheet(QString::fromUtf8("color: rgb(0,0,0);"));
-        }
-    }
+    device->changeSkinContact(value == 0);
 }
 
 
@@ -596,90 +586,10 @@ void MainWindow::skinContactAdminChange(int value)
  */
 void MainWindow::deviceEnabledChange(int value)
 {
-    //If changed to false
-    if(value == 1){
-
-        //If device was treating, end session. Record it if that was set
-        if(device->getIsTreating()){
-            device->stopSession(device->getCurrSession()->getLastDuration()-device->getCurrSession()->getDuration());
-            ui->contactSkinValue->setCurrentIndex(1);
-        }
-
-        //Disable device, timers, and turn off screen and buttons
-        device->setIsDisabled(true);
-        device->setIsOn(false);
-        inactivityTimer->stop();
-        batteryTimer->stop();
-        turnOffDevice();
-
-
-
-    //Re-enabling device from admin area
-    }else{
-
-        //Reset the battery burn rate (not turning it on though), re-enable device
-        //set uA of device back to 100
-        device->getBattery()->defaultBurnRate();
-        device->setIsDisabled(false);
-        ui->powerLevelAdminValue->setValue(100);
-    }
+    LatencyScope timing(slotTimes[DeviceEnabledChangeSlot]);
+    TraceScope trace("deviceEnabledChange", "slot");
 
-}
-
-/**
- * Triggered when battery timer runs out. Updates battery percentage
- */
-void MainWindow::batteryUpdate()
-{
-    //If the device is on, battery can be depleted
-    if(device->getIsOn()){
-
-        //Simulate battery depletion
-        device->getBattery()->depleteBattery();
-
-        int batteryPercentage = device->getBattery()->getBatteryPercentage();
-
-        //Display the device's current battery level on the device and in admin
-        ui->batteryLevelBar->setValue(batteryPercentage);
-        ui->batteryPercentageValue->setValue(batteryPercentage);
-
-        //Display warning if device is at 5% battery
-        if(batteryPercentage == 5 && !device->getBattery()->getFiveWarning()){
-
-            //Display warning message
-            QMessageBox lowBattery;
-            lowBattery.setText("<) Warning: Your battery is low at 5%. <)");
-            lowBattery.exec();
-
-            //Set battery warning to displayed
-            device->getBattery()->setFiveWarning(true);
-
-
-        //Display warning if device is at 2% battery and turn off device
-        }else if(batteryPercentage == 2){
-
-            //Display warning message
-            QMessageBox lowBattery;
-            lowBattery.setText("<) Warning: Your battery is low at 2%. Shutting down the device. <)");
-            lowBattery.exec();
-
-            //Turn off device if battery reaches 2%. Stop depleting battery. Stop inactivity timer
-            if(device->getIsTreating()){
-                device->stopSession(device->getCurrSession()->getLastDuration()-device->getCurrSession()->getDuration());
-                ui->contactSkinValue->setCurrentIndex(1);
-            }
-
-            device->setIsOn(false);
-            turnOffDevice();
-            inactivityTimer->stop();
-            batteryTimer->stop();
-
-
-        //Set the 5% warning to available again
-        }else if(batteryPercentage != 5){
-            device->getBattery()->setFiveWarning(false);
-        }
-    }
+    device->changeDeviceEnabled(value == 0);
 }
 
 /**
@@ -688,48 +598,38 @@ void MainWindow::batteryUpdate()
  */
 void MainWindow::adminBatteryUpdate(int value)
 {
-    //Update the device's battery with the new percent
-    device->getBattery()->setBatteryPercentage(value);
-
-    //Change the displayed battery level on the device
-    ui->batteryLevelBar->setValue(value);
-
+    LatencyScope timing(slotTimes[AdminBatteryUpdateSlot]);
+    TraceScope trace("adminBatteryUpdate", "slot");
 
+    //Update the device's battery with the new percent
+    device->changeBatteryPercentage(value);
 }
 
 /**
- * Called when inactivity timer times out or timer is increased by one second in admin area
+ * Triggered when user changes the simulation speed in admin area
+ * @param index is the index of the dropdown (0 = 1x, 1 = 10x, 2 = 100x, 3 = as fast as possible)
  */
-void MainWindow::inactivityUpdate()
+void MainWindow::speedChange(int index)
 {
-    //Check device is not currently treating
-    if(!device->getIsTreating()){
-
-        //Increase number of seconds inactive and update display
-        inactiveSeconds += 60;
-        displayInactiveTime();
-
-        //If 30 minutes of inactivity reached, turn off device
-        if(inactiveSeconds == 1800){
-            device->setIsOn(false);
-            turnOffDevice();
-            inactivityTimer->stop();
+    LatencyScope timing(slotTimes[SpeedChangeSlot]);
+    TraceScope trace("speedChange", "slot");
 
+    const int speeds[] = { 1, 10, 100, Scheduler::MAX_SPEED };
+    if(index < 0 || index > 3){ return; }
 
-        }
-    }
+    //Every timer of the device runs on this clock, they all speed up together
+    scheduler->setSpeed(speeds[index]);
 }
 
-
 /**
- * Updates the display of the inactive timer
+ * Triggered when the inactive time is increased by one minute in admin area
  */
-void MainWindow::displayInactiveTime()
+void MainWindow::inactivityUpdate()
 {
-    //Convert seconds to "mm:ss" and display it
-    QTime time = QTime(0,0,0).addSecs(inactiveSeconds);
-    ui->inactivityTimer->display(time.toString("mm:ss"));
+    LatencyScope timing(slotTimes[InactivityUpdateSlot]);
+    TraceScope trace("inactivityUpdate", "slot");
 
+    device->inactivityUpdate();
 }
 
 
@@ -738,8 +638,10 @@ void MainWindow::displayInactiveTime()
  */
 void MainWindow::resetInactivity()
 {
-    inactiveSeconds = 0;
-    displayInactiveTime();
+    LatencyScope timing(slotTimes[ResetInactivitySlot]);
+    TraceScope trace("resetInactivity", "slot");
+
+    device->resetInactivity();
 }
 
 /**
@@ -747,6 +649,9 @@ void MainWindow::resetInactivity()
  */
 void MainWindow::turnOffDevice()
 {
+    LatencyScope timing(slotTimes[TurnOffDeviceSlot]);
+    TraceScope trace("turnOffDevice", "slot");
+
     //Disable on device buttons
     ui->recordButton->setEnabled(false);
     ui->selectButton->setEnabled(false);
@@ -754,10 +659,6 @@ void MainWindow::turnOffDevice()
     ui->downButton->setEnabled(false);
     ui->returnButton->setEnabled(false);
 
-    //Set recording to false
-    ui->recordingLabel->setText("Not Recording");
-    device->setRecording(false);
-
     //Disable the screen
     ui->screenFrame->setStyleSheet(QString::fromUtf8("background-color: rgb(85, 87, 83);"));
     ui->screenTabs->setHidden(true);
@@ -770,6 +671,9 @@ void MainWindow::turnOffDevice()
  */
 void MainWindow::turnOnDevice()
 {
+    LatencyScope timing(slotTimes[TurnOnDeviceSlot]);
+    TraceScope trace("turnOnDevice", "slot");
+
     //Enable on device buttons
     ui->recordButton->setEnabled(true);
     ui->selectButton->setEnabled(true);
@@ -785,26 +689,121 @@ void MainWindow::turnOnDevice()
 }
 
 /**
- * Called when 5 seconds elapses after losing contact with skin during a therapy session
+ * The device's therapy timer shows a new value, displayed on the next frame
+ * @param text is the "mm:ss" text to display
  */
-void MainWindow::skinContactUpdate()
+void MainWindow::timerDisplayChanged(const QString& text)
 {
-    //If therapy is not running again when timer ends, stop the therapy, set device to not treating and reset ui
-    if(!device->getCurrSession()->getIsRunning()){
-
-        device->stopSession(device->getCurrSession()->getLastDuration() - device->getCurrSession()->getDuration());
+    timerText = text;
+    timerTextChanged = true;
+}
 
-        device->setIsTreating(false);
-        ui->notTreatingLabel->setText("Not Treating");
+/**
+ * A finished therapy session was recorded, the record is already in the store.
+ * Newest records go on top
+ * @param record is the saved record
+ */
+void MainWindow::recordSaved(const SessionRecord& record)
+{
+    (void)record;
+    recordModel->recordAdded();
+    showUsage();
+}
 
-        ui->recordingLabel->setText("Not Recording");
-        device->setRecording(false);
+/**
+ * The device was turned on or off, turn the screen and buttons on or off with it
+ * @param isOn is the new power status
+ */
+void MainWindow::powerChanged(bool isOn)
+{
+    if(isOn){
+        turnOnDevice();
+    }else{
+        turnOffDevice();
+    }
+}
 
-        ui->powerLevelBar->setValue(2);
-        ui->powerLevelAdminValue->setValue(100);
-        device->getBattery()->defaultBurnRate();
+/**
+ * The device started or stopped treating
+ * @param isTreating is the new treating status
+ */
+void MainWindow::treatingChanged(bool isTreating)
+{
+    ui->notTreatingLabel->setText(isTreating ? "Treating" : "Not Treating");
 
-        ui->timerOnLabel->setStyleSheet(QString::fromUtf8("color: rgb(238,238,236);"));
+    if(isTreating){
+        ui->timerOnLabel->setStyleSheet(QString::fromUtf8("color: rgb(0,0,0);"));
     }
 }
 
+/**
+ * Recording was turned on or off
+ * @param isRecording is the new recording status
+ */
+void MainWindow::recordingChanged(bool isRecording)
+{
+    ui->recordingLabel->setText(isRecording ? "Recording" : "Not Recording");
+}
+
+/**
+ * The earclips touched or left the skin. The admin dropdown follows without
+ * sending the change back to the device.
+ * @param isContacting is the new skin contact status
+ */
+void MainWindow::contactChanged(bool isContacting)
+{
+    ui->skinLabel->setText(isContacting ? "Contact On" : "Contact Off");
+
+    QSignalBlocker blocker(ui->contactSkinValue);
+    ui->contactSkinValue->setCurrentIndex(isContacting ? 0 : 1);
+}
+
+/**
+ * The device was disabled or re-enabled
+ * @param isEnabled is the new enabled status
+ */
+void MainWindow::enabledChanged(bool isEnabled)
+{
+    QSignalBlocker blocker(ui->deviceEnabledValue);
+    ui->deviceEnabledValue->setCurrentIndex(isEnabled ? 0 : 1);
+}
+
+/**
+ * The power level changed, display it on the device and in admin
+ * @param level is the new power level (0 - 10)
+ */
+void MainWindow::powerLevelChanged(int level)
+{
+    ui->powerLevelBar->setValue(level);
+
+    QSignalBlocker blocker(ui->powerLevelAdminValue);
+    ui->powerLevelAdminValue->setValue(level * 50);
+}
+
+/**
+ * The battery percentage changed, display it on the device and in admin on the next frame
+ * @param percentage is the new battery percentage
+ */
+void MainWindow::batteryChanged(int percentage)
+{
+    batteryPercentage = percentage;
+    batteryPercentageChanged = true;
+}
+
+/**
+ * The battery reached 5% or 2%, queue the warning message for the next frame.
+ * It returns at once, the device's timers go on while the warning is shown.
+ * @param percentage is the battery percentage that was reached
+ */
+void MainWindow::batteryWarning(int percentage)
+{
+    notifications->post(percentage, NotificationQueue::batteryWarning(percentage));
+}
+
+/**
+ * A session ended and the device reset for the next one, hide the timer
+ */
+void MainWindow::sessionEnded()
+{
+    ui->timerOnLabel->setStyleSheet(QString::fromUtf8("color: rgb(238,238,236);"));
+}
@@ -2,7 +2,11 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <QTimer>
 #include "cesdevice.h"
+#include "deviceobserver.h"
+#include "notificationqueue.h"
+#include "recordlistmodel.h"
 #include <string.h>
 
 
@@ -13,6 +17,17 @@ Purpose: This class serves as the frontend representation of the CES device.
 
 Usage: Provides functionality for and helps display the user interface.
        Handles buttons/tabs/spinboxes on device or in admin area:
+       Forwards them to the CESDevice and displays the changes the device reports
+       as its DeviceObserver.
+       Times every slot and shows the latency percentiles of the slots and device timers
+       in the admin area, and writes them to latency.txt on exit.
+       Logs the inputs and timers of the device to events.log, for ces-headless --replay.
+       Runs the device's clock at 1x, 10x, 100x or as fast as possible (speed in the admin area).
+       The therapy timer, battery and inactivity displays show the latest values once per frame,
+       however often the device changes them. The inactive time is read from the device
+       (it is not reported every second) while its display is visible.
+       Battery warnings are queued and shown in the status bar by the next frame, without
+       stopping the device (a repeated warning that was not shown yet is shown once, with its count).
 
 */
 
@@ -21,7 +36,7 @@ QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
 QT_END_NAMESPACE
 
-class MainWindow : public QMainWindow
+class MainWindow : public QMainWindow, public DeviceObserver
 {
     Q_OBJECT
 
@@ -29,13 +44,62 @@ public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+    //DeviceObserver
+    void timerDisplayChanged(const QString& text) override;
+    void recordSaved(const SessionRecord& record) override;
+    void powerChanged(bool isOn) override;
+    void treatingChanged(bool isTreating) override;
+    void recordingChanged(bool isRecording) override;
+    void contactChanged(bool isContacting) override;
+    void enabledChanged(bool isEnabled) override;
+    void powerLevelChanged(int level) override;
+    void batteryChanged(int percentage) override;
+    void batteryWarning(int percentage) override;
+    void sessionEnded() override;
+
 private:
     Ui::MainWindow *ui;
+    Scheduler* scheduler;
     CESDevice* device;
-    QTimer* batteryTimer;
-    QTimer* inactivityTimer;
-    QTimer* skinOffTimer;
+    OutputThread* output;
+    RecordStore* recordStore;
+    RecordListModel* recordModel;
+    UsageRollups* usageRollups;
+    LatencyStats* latencyStats;
+    EventLog* eventLog;
+    NotificationQueue* notifications;
+    enum SlotIndex
+    {
+        PowerClickSlot,
+        RecordClickSlot,
+        DownClickSlot,
+        UpClickSlot,
+        SelectClickSlot,
+        ReturnClickSlot,
+        PowerLevelAdminChangeSlot,
+        SkinContactAdminChangeSlot,
+        DeviceEnabledChangeSlot,
+        AdminBatteryUpdateSlot,
+        SpeedChangeSlot,
+        InactivityUpdateSlot,
+        ResetInactivitySlot,
+        TurnOnDeviceSlot,
+        TurnOffDeviceSlot,
+        SLOTS
+    };
+    LatencyHistogram* slotTimes[SLOTS];
+    QTimer* outputStatusTimer;
+    QTimer* displayTimer;
+    QString timerText;
+    int batteryPercentage;
     int inactiveSeconds;
+    bool timerTextChanged;
+    bool batteryPercentageChanged;
+
+    void showOutputStatus();
+    void showLatency();
+    void showUsage();
+    void showDisplay();
 
 private slots:
     void powerClick();
@@ -47,15 +111,12 @@ private slots:
     void powerLevelAdminChange(int);
     void skinContactAdminChange(int);
     void deviceEnabledChange(int);
-    void batteryUpdate();
     void adminBatteryUpdate(int);
+    void speedChange(int);
     void inactivityUpdate();
-    void displayInactiveTime();
     void resetInactivity();
     void turnOnDevice();
     void turnOffDevice();
-    void skinContactUpdate();
-    void resetUI();
 
 };
 #endif // MAINWINDOW_H
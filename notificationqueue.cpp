@@ -0,0 +1,93 @@
+#include "notificationqueue.h"
+
+/**
+ * Constructor for the NotificationQueue, nothing is pending
+ */
+NotificationQueue::NotificationQueue()
+{
+    this->posted = 0;
+    this->coalesced = 0;
+}
+
+/**
+ * Adds a notification at the end of the queue. If one with the same key is still pending,
+ * it keeps its place and takes the new text, and the count is added to it instead.
+ *
+ * @param key identifies the notification
+ * @param text is the text to show
+ * @param count is the number of times it was given, more than 1 for several devices at once
+ */
+void NotificationQueue::post(int key, const QString& text, qint64 count)
+{
+    if(count <= 0){ return; }
+    posted += count;
+
+    //At most a few keys are pending, a scan is the fastest lookup
+    for(Notification& notification : pending){
+        if(notification.key == key){
+            notification.text = text;
+            notification.count += count;
+            coalesced += count;
+            return;
+        }
+    }
+
+    pending.push_back(Notification{key, text, count});
+    coalesced += count - 1;
+}
+
+/**
+ * Takes the oldest pending notification out of the queue
+ *
+ * @param notification is set to the notification taken
+ * @return false if no notification is pending
+ */
+bool NotificationQueue::take(Notification& notification)
+{
+    if(pending.empty()){ return false; }
+
+    notification = pending.front();
+    pending.pop_front();
+    return true;
+}
+
+/**
+ * Drops every pending notification
+ */
+void NotificationQueue::clear()
+{
+    pending.clear();
+}
+
+/**
+ * Whether no notification is pending
+ * @return true if the queue is empty
+ */
+bool NotificationQueue::isEmpty(){ return pending.empty(); }
+
+/**
+ * Get the number of notifications posted so far, with their count
+ * @return the number of notifications
+ */
+qint64 NotificationQueue::getPosted(){ return posted; }
+
+/**
+ * Get the number of notifications that were coalesced into a pending one
+ * @return the number of notifications
+ */
+qint64 NotificationQueue::getCoalesced(){ return coalesced; }
+
+/**
+ * Text of a battery warning
+ *
+ * @param percentage is the battery percentage that was reached, 5 or 2
+ * @return the text of the warning
+ */
+QString NotificationQueue::batteryWarning(int percentage)
+{
+    if(percentage == 5){
+        return "<) Warning: Your battery is low at 5%. <)";
+    }
+
+    return "<) Warning: Your battery is low at 2%. Shutting down the device. <)";
+}
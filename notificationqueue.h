@@ -0,0 +1,52 @@
+#ifndef NOTIFICATIONQUEUE_H
+#define NOTIFICATIONQUEUE_H
+
+#include <QString>
+#include <deque>
+
+/*
+Class: NotificationQueue
+
+Purpose: This class holds the warnings of the device until whoever shows them gets to them,
+         so giving a warning never waits for anyone (no dialog, no nested event loop in a timer).
+
+Usage: post() adds a notification and returns at once, take() gets the oldest one that is pending.
+       A notification is identified by its key (the battery warnings use their percentage): posting
+       a key that is still pending does not add a second one, it replaces the text of the pending one
+       and adds to its count. So a fast clock or a run of many devices leaves at most one pending
+       notification per key, however often it is given.
+        - the GUI shows the pending notifications one at a time in its status bar, once per frame
+        - headless and fleet runs post the warnings of all their devices and print them at the end
+       batteryWarning() is the text of a battery warning, the same everywhere it is shown.
+*/
+
+class NotificationQueue
+{
+public:
+    struct Notification
+    {
+        int key;                //Identifies the notification, a pending one with the same key is coalesced
+        QString text;           //Text to show, the latest posted
+        qint64 count;           //Number of times it was posted while pending
+    };
+
+    NotificationQueue();
+
+    void post(int key, const QString& text, qint64 count = 1);  //Add a notification or coalesce it with the pending one of its key
+    bool take(Notification& notification);                      //Take the oldest pending notification, false if there is none
+    void clear();                                               //Drop every pending notification
+
+    //Getters
+    bool isEmpty();                 //Whether no notification is pending
+    qint64 getPosted();             //Notifications posted so far (with their count)
+    qint64 getCoalesced();          //Notifications that were coalesced into a pending one
+
+    static QString batteryWarning(int percentage);  //Text of the warning at 5% or 2% battery
+
+private:
+    std::deque<Notification> pending;   //Pending notifications, oldest first, one per key
+    qint64 posted;                      //Notifications posted so far
+    qint64 coalesced;                   //Notifications coalesced into a pending one
+};
+
+#endif // NOTIFICATIONQUEUE_H
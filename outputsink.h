@@ -0,0 +1,25 @@
+#ifndef OUTPUTSINK_H
+#define OUTPUTSINK_H
+
+#include <QtGlobal>
+
+/*
+Class: OutputSink
+
+Purpose: Interface for whatever receives the simulated output current of the CES device.
+
+Usage: The OutputThread hands every block of current samples (in uA) to its sink when the block
+       is due, on the output thread. A sink must not block: it copies or consumes the samples
+       and returns. Every method has an empty default implementation, so a sink only overrides
+       what it needs.
+*/
+
+class OutputSink
+{
+public:
+    virtual ~OutputSink() {}
+
+    virtual void writeBlock(const float* samples, int count, qint64 deadline) { (void)samples; (void)count; (void)deadline; }  //A block of samples due at deadline (ns on the output clock)
+};
+
+#endif // OUTPUTSINK_H
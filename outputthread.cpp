@@ -0,0 +1,170 @@
+#include "outputthread.h"
+
+#include <chrono>
+
+/**
+ * Used by output threads that were created without a sink, the samples are dropped
+ */
+static OutputSink noSink;
+
+
+/**
+ * Constructor for the OutputThread. The output starts silent, the thread is not started.
+ *
+ * @param sink receives every block of samples, may be nullptr
+ * @param sampleRate is the number of samples per second, raised to the generator's lowest if it is lower
+ * @param blockSize is the number of samples handed to the sink at once, at least 1
+ */
+OutputThread::OutputThread(OutputSink* sink, int sampleRate, int blockSize)
+    : generator(sampleRate), block(blockSize > 0 ? blockSize : 1), latestCommand(0), running(false), blocksWritten(0),
+      underruns(0), deadlineMisses(0)
+{
+    this->submitted = 0;
+    this->sink = sink != nullptr ? sink : &noSink;
+    this->sampleRate = generator.getSampleRate();
+    this->blockSize = (int)block.size();
+    this->blockPeriod = (qint64)this->blockSize * 1000000000 / this->sampleRate;
+
+    generator.configure(0, 0, 0);
+}
+
+/**
+ * Deconstructor for the OutputThread, stops the thread if it is running
+ */
+OutputThread::~OutputThread()
+{
+    stop();
+}
+
+/**
+ * Starts the output thread. Does nothing if it is already running.
+ */
+void OutputThread::start()
+{
+    if(running.exchange(true)){ return; }
+
+    worker = std::thread(&OutputThread::run, this);
+}
+
+/**
+ * Stops the output thread and waits for it to finish its current block
+ */
+void OutputThread::stop()
+{
+    running = false;
+
+    if(worker.joinable()){
+        worker.join();
+    }
+}
+
+/**
+ * Sends new settings to the output thread. Never blocks, must always be called from the same thread.
+ * Only the latest command matters: it replaces the one in the mailbox, whether it was applied or not.
+ * Each field is packed in a byte (waveform and frequency 0 - 2, power level 0 - 10).
+ *
+ * @param command is the new waveform, frequency, power level and whether current flows
+ */
+void OutputThread::submit(const OutputCommand& command)
+{
+    quint32 packed = (quint32)(quint8)command.waveform | (quint32)(quint8)command.frequency << 8
+                   | (quint32)(quint8)command.powerLevel << 16 | (quint32)(command.active ? 1 : 0) << 24;
+
+    //The count makes every submit a new value, so the output thread sees that it changed
+    submitted++;
+    latestCommand.store((quint64)submitted << 32 | packed, std::memory_order_release);
+}
+
+/**
+ * Loop of the output thread. Block k is due k block periods after the start;
+ * the thread wakes up when block k - 1 is due, renders block k and hands it to the sink.
+ */
+void OutputThread::run()
+{
+    typedef std::chrono::steady_clock Clock;
+
+    const Clock::time_point origin = Clock::now();
+    const qint64 missTolerance = blockPeriod / 4;
+    qint64 next = 1;
+    quint64 applied = 0;
+
+    while(running){
+
+        //Sleep until the previous block is due
+        qint64 wakeTime = (next - 1) * blockPeriod;
+        std::this_thread::sleep_until(origin + std::chrono::nanoseconds(wakeTime));
+
+        qint64 now = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - origin).count();
+        if(now - wakeTime > missTolerance){
+            deadlineMisses++;
+        }
+
+        //More than a block behind: the blocks in between are lost, start again from now
+        //instead of bursting to catch up
+        if(now >= next * blockPeriod){
+            qint64 skipped = now / blockPeriod - next + 1;
+            underruns += skipped;
+            next += skipped;
+        }
+
+        //Apply the latest settings if they changed
+        quint64 latest = latestCommand.load(std::memory_order_acquire);
+        if(latest != applied){
+            int waveform = (int)(latest & 0xff);
+            int frequency = (int)(latest >> 8 & 0xff);
+            int powerLevel = (int)(latest >> 16 & 0xff);
+            bool active = (latest >> 24 & 1) != 0;
+
+            generator.configure(waveform, frequency, active ? powerLevel : 0);
+            applied = latest;
+        }
+
+        generator.generate(block.data(), blockSize);
+
+        qint64 deadline = next * blockPeriod;
+        qint64 ready = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - origin).count();
+        if(ready > deadline){
+            underruns++;
+        }
+
+        sink->writeBlock(block.data(), blockSize, deadline);
+        blocksWritten++;
+        next++;
+    }
+}
+
+/**
+ * Get whether the output thread is running
+ * @return true if it was started and not stopped
+ */
+bool OutputThread::isRunning(){ return running; }
+
+/**
+ * Get the number of samples per second
+ * @return the sample rate
+ */
+int OutputThread::getSampleRate(){ return sampleRate; }
+
+/**
+ * Get the number of samples handed to the sink at once
+ * @return the block size
+ */
+int OutputThread::getBlockSize(){ return blockSize; }
+
+/**
+ * Get the number of blocks handed to the sink so far
+ * @return the number of blocks
+ */
+qint64 OutputThread::getBlocksWritten(){ return blocksWritten; }
+
+/**
+ * Get the number of blocks that were not ready when they were due
+ * @return the number of underruns
+ */
+qint64 OutputThread::getUnderruns(){ return underruns; }
+
+/**
+ * Get the number of times the output thread woke up more than a quarter of a block late
+ * @return the number of deadline misses
+ */
+qint64 OutputThread::getDeadlineMisses(){ return deadlineMisses; }
@@ -0,0 +1,82 @@
+#ifndef OUTPUTTHREAD_H
+#define OUTPUTTHREAD_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "outputsink.h"
+#include "waveformgenerator.h"
+
+/*
+Struct: OutputCommand
+
+Purpose: Settings of the output current, sent from the session logic to the OutputThread.
+*/
+
+struct OutputCommand
+{
+    int waveform;           //0 - Alpha, 1 - Beta, 2 - Gamma
+    int frequency;          //0 - 0.5Hz, 1 - 77Hz, 2 - 100Hz
+    int powerLevel;         //0 - 10 (50uA per level)
+    bool active;            //Whether current flows (treating with the earclips on the skin)
+};
+
+
+/*
+Class: OutputThread
+
+Purpose: This class produces the simulated output current of the CES device on its own thread,
+         on a hard cadence that nothing on the GUI thread can stall.
+
+Usage: The session logic (one producer thread) calls submit() with the new settings whenever they
+       change. Only the latest settings matter, so they go into a single atomic mailbox that every
+       submit() overwrites: submit() never blocks or fails, the output thread never waits for the
+       producer, and the newest settings (e.g. current stopped) are never lost.
+       The output thread renders one block of samples ahead: it wakes up when block k - 1 is due,
+       applies the latest command, renders block k with a WaveformGenerator and hands it to
+       the OutputSink when it is due. Wake-ups are on absolute deadlines, so the cadence doesn't drift.
+       It counts:
+        - deadline misses: the thread woke up more than a quarter of a block late
+        - underruns: a block was ready only after it was due (the output ran dry), including
+          blocks that were skipped because the thread fell more than a block behind
+*/
+
+class OutputThread
+{
+public:
+    OutputThread(OutputSink* sink = nullptr, int sampleRate = 48000, int blockSize = 480);
+    ~OutputThread();
+
+    void start();                                   //Start producing samples on the output thread
+    void stop();                                    //Stop the output thread and wait for it
+    void submit(const OutputCommand& command);      //Send new settings, from the producer thread only
+
+    //Getters
+    bool isRunning();                   //Whether the output thread is running
+    int getSampleRate();                //Samples per second
+    int getBlockSize();                 //Samples per block
+    qint64 getBlocksWritten();          //Blocks handed to the sink
+    qint64 getUnderruns();              //Blocks that were not ready when they were due
+    qint64 getDeadlineMisses();         //Wake-ups more than a quarter of a block late
+
+private:
+    OutputSink* sink;                           //Receives the samples
+    int sampleRate;                             //Samples per second
+    int blockSize;                              //Samples per block
+    qint64 blockPeriod;                         //Length of a block in ns
+    WaveformGenerator generator;                //Renders the samples, only used by the output thread
+    std::vector<float> block;                   //Samples of the block being rendered
+    std::atomic<quint64> latestCommand;         //Latest settings from the producer: submit count in the high 32 bits, the command packed below
+    quint32 submitted;                          //Number of submit() calls, producer thread only
+    std::thread worker;                         //The output thread
+    std::atomic<bool> running;                  //Cleared to stop the output thread
+    std::atomic<qint64> blocksWritten;          //Blocks handed to the sink
+    std::atomic<qint64> underruns;              //Blocks that were not ready when they were due
+    std::atomic<qint64> deadlineMisses;         //Late wake-ups
+
+    void run();                                 //Loop of the output thread
+};
+
+#endif // OUTPUTTHREAD_H
@@ -0,0 +1,428 @@
+#include "recordformatter.h"
+
+#include <QDateTime>
+#include <QLocale>
+#include <cstring>
+
+/**
+ * A piece of text with its length known at compile time
+ */
+struct Label
+{
+    const char* text;
+    int length;
+};
+
+template<int N>
+static constexpr Label label(const char (&text)[N]) { return Label{ text, N - 1 }; }
+
+//Labels of each waveform (0 - Alpha, 1 - Beta, 2 - Gamma)
+static constexpr Label WAVEFORM_LABELS[3] = {
+    label(", Waveform: Alpha"), label(", Waveform: Betta"), label(", Waveform: Gamma")
+};
+
+//Labels of each frequency (0 - 0.5Hz, 1 - 77Hz, 2 - 100Hz)
+static constexpr Label FREQUENCY_LABELS[3] = {
+    label(", Freq: 0.5Hz"), label(", Freq: 77Hz"), label(", Freq: 100Hz")
+};
+
+static constexpr Label ID_LABEL = label("\nID: ");
+static constexpr Label DURATION_LABEL = label(", Duration: ");
+static constexpr Label MINUTES_LABEL = label(":00");
+static constexpr Label POWER_LABEL = label(", Powerlevel: ");
+
+//Text of every number from 00 to 99
+static constexpr char DIGIT_PAIRS[] =
+    "0001020304050607080910111213141516171819202122232425262728293031323334353637383940414243444546474849"
+    "5051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+
+
+/**
+ * Copies bytes to the buffer, as many as fit.
+ * The write position is passed by value and returned: a char pointer reached through a
+ * reference could alias the bytes written, which stops the compiler keeping it in a register.
+ *
+ * @param out is the write position
+ * @param end is the end of the buffer
+ * @param text is the bytes to copy
+ * @param length is the number of bytes
+ * @return the write position after the bytes
+ */
+static inline char* put(char* out, char* end, const char* text, int length)
+{
+    if(length > end - out){ length = (int)(end - out); }
+    memcpy(out, text, length);
+    return out + length;
+}
+
+/**
+ * Writes a number in decimal
+ *
+ * @param out is the write position
+ * @param end is the end of the buffer
+ * @param value is the number
+ * @param width is the smallest number of digits (padded with zeros)
+ * @return the write position after the digits
+ */
+static inline char* putNumber(char* out, char* end, quint32 value, int width)
+{
+    int count = 1;
+    for(quint32 rest = value; rest >= 10; rest /= 10){ count++; }
+    if(count < width){ count = width; }
+    if(count > end - out){ return out; }
+
+    //Two digits at a time from the right
+    char* digit = out + count;
+    while(value >= 100){
+        digit -= 2;
+        memcpy(digit, DIGIT_PAIRS + value % 100 * 2, 2);
+        value /= 100;
+    }
+    if(value >= 10){
+        digit -= 2;
+        memcpy(digit, DIGIT_PAIRS + value * 2, 2);
+    }else{
+        *--digit = (char)('0' + value);
+    }
+    while(digit > out){ *--digit = '0'; }
+
+    return out + count;
+}
+
+
+/**
+ * Constructor for the RecordFormatter. Reads the locale's texts and splits the date/time pattern.
+ *
+ * @param datePattern is the date/time pattern to use (QDateTime::toString() syntax),
+ *        empty for the locale's short format like Qt::DefaultLocaleShortDate
+ */
+RecordFormatter::RecordFormatter(const QString& datePattern)
+{
+    QLocale locale;
+
+    amText = locale.amText().toUtf8();
+    pmText = locale.pmText().toUtf8();
+    amLower = locale.amText().toLower().toUtf8();
+    pmLower = locale.pmText().toLower().toUtf8();
+
+    for(int i = 0; i < 12; i++){
+        monthNames[0][i] = locale.monthName(i + 1, QLocale::ShortFormat).toUtf8();
+        monthNames[1][i] = locale.monthName(i + 1, QLocale::LongFormat).toUtf8();
+    }
+    for(int i = 0; i < 7; i++){
+        dayNames[0][i] = locale.dayName(i + 1, QLocale::ShortFormat).toUtf8();
+        dayNames[1][i] = locale.dayName(i + 1, QLocale::LongFormat).toUtf8();
+    }
+
+    parse(datePattern.isEmpty() ? locale.dateTimeFormat(QLocale::ShortFormat) : datePattern);
+
+    windowStart = 0;
+    windowLength = 0;
+    year = month = day = dayOfWeek = firstHour = 0;
+
+    //No hour rendered yet, record times are never this far back
+    hourStart = -1;
+    hourPattern.reserve(pattern.size() + 2);
+}
+
+/**
+ * Deconstructor for the RecordFormatter
+ */
+RecordFormatter::~RecordFormatter()
+{
+
+}
+
+/**
+ * Splits a date/time pattern into fields, following the QDateTime::toString() syntax:
+ * runs of d, M, y, h, H, m, s, AP/ap are fields, text in single quotes and anything else is copied.
+ *
+ * @param datePattern is the pattern
+ */
+void RecordFormatter::parse(const QString& datePattern)
+{
+    QByteArray text = datePattern.toUtf8();
+    const char* chars = text.constData();
+    int size = text.size();
+
+    //Hours are 12 hour ones when the pattern has an AM/PM field
+    bool twelveHour = false;
+    for(int i = 0; i < size; i++){
+        if(chars[i] == 'A' || chars[i] == 'a'){ twelveHour = true; }
+    }
+
+    pattern.clear();
+    literals.clear();
+
+    for(int i = 0; i < size;){
+        char c = chars[i];
+        int run = 1;
+        while(i + run < size && chars[i + run] == c){ run++; }
+
+        Token token;
+        token.field = Literal;
+        token.start = 0;
+        token.length = 0;
+
+        if(c == '\''){
+            //Quoted text, '' is a quote
+            int j = i + 1;
+            token.start = literals.size();
+            if(j < size && chars[j] == '\''){
+                literals.append('\'');
+                j++;
+            }else{
+                while(j < size){
+                    if(chars[j] == '\'' && j + 1 < size && chars[j + 1] == '\''){
+                        literals.append('\'');
+                        j += 2;
+                    }else if(chars[j] == '\''){
+                        break;
+                    }else{
+                        literals.append(chars[j++]);
+                    }
+                }
+                j++;
+            }
+            token.length = literals.size() - token.start;
+            pattern.push_back(token);
+            i = j;
+            continue;
+        }
+
+        switch(c)
+        {
+        case 'd':
+            run = run > 4 ? 4 : run;
+            token.field = run == 1 ? Day : run == 2 ? Day2 : run == 3 ? DayShortName : DayName;
+            break;
+        case 'M':
+            run = run > 4 ? 4 : run;
+            token.field = run == 1 ? Month : run == 2 ? Month2 : run == 3 ? MonthShortName : MonthName;
+            break;
+        case 'y':
+            run = run >= 4 ? 4 : 2;
+            token.field = run == 4 ? Year4 : Year2;
+            break;
+        case 'h':
+            run = run > 2 ? 2 : run;
+            token.field = twelveHour ? (run == 1 ? Hour12 : Hour12Two) : (run == 1 ? Hour24 : Hour24Two);
+            break;
+        case 'H':
+            run = run > 2 ? 2 : run;
+            token.field = run == 1 ? Hour24 : Hour24Two;
+            break;
+        case 'm':
+            run = run > 2 ? 2 : run;
+            token.field = run == 1 ? Minute : Minute2;
+            break;
+        case 's':
+            run = run > 2 ? 2 : run;
+            token.field = run == 1 ? Second : Second2;
+            break;
+        case 'A':
+        case 'a':
+            //AP, ap, A or a
+            run = (i + 1 < size && (chars[i + 1] == 'P' || chars[i + 1] == 'p')) ? 2 : 1;
+            token.field = c == 'A' ? AmPm : AmPmLower;
+            break;
+        case 't':
+            //Time zone, the records tab never showed it
+            i += run;
+            continue;
+        default:
+            token.start = literals.size();
+            literals.append(QByteArray(chars + i, run));
+            token.length = run;
+            break;
+        }
+
+        pattern.push_back(token);
+        i += run;
+    }
+}
+
+/**
+ * Looks up the local date of a time, unless it is in the window looked up last.
+ * The window is the whole local day when the clocks don't change that day, so its times are
+ * plain arithmetic from midnight. On the days they change it is the hour holding the time.
+ *
+ * @param startTime is the time (seconds since the epoch)
+ */
+void RecordFormatter::cacheWindow(qint64 startTime)
+{
+    if(startTime >= windowStart && startTime - windowStart < windowLength){ return; }
+
+    const QDateTime dt = QDateTime::fromSecsSinceEpoch(startTime);
+    const QDate date = dt.date();
+    const QTime time = dt.time();
+
+    year = date.year();
+    month = date.month();
+    day = date.day();
+    dayOfWeek = date.dayOfWeek();
+
+    //The day is a whole 24 hours away from midnight if its last second is 23:59:59 of the same day
+    const qint64 dayStart = startTime - time.hour() * 3600 - time.minute() * 60 - time.second();
+    const QDateTime dayEnd = QDateTime::fromSecsSinceEpoch(dayStart + 86399);
+
+    if(dayEnd.date() == date && dayEnd.time() == QTime(23, 59, 59)){
+        windowStart = dayStart;
+        windowLength = 86400;
+        firstHour = 0;
+    }else{
+        //The hour is only a window if its clock runs from hh:00:00 to hh:59:59 too, which
+        //changes of half an hour break. Nothing is cached in such an hour.
+        windowStart = startTime - time.minute() * 60 - time.second();
+        firstHour = time.hour();
+
+        const QDateTime hourFirst = QDateTime::fromSecsSinceEpoch(windowStart);
+        const QDateTime hourLast = QDateTime::fromSecsSinceEpoch(windowStart + 3599);
+        bool wholeHour = hourFirst.time() == QTime(firstHour, 0, 0) && hourLast.time() == QTime(firstHour, 59, 59);
+
+        windowLength = wholeHour ? 3600 : 0;
+        if(!wholeHour){ hourStart = -1; }
+    }
+}
+
+/**
+ * Writes one field of the date/time pattern
+ *
+ * @param out is the write position
+ * @param end is the end of the buffer
+ * @param token is the field to write
+ * @param text holds the bytes of a literal field
+ * @param hour is the local hour, 0 - 23
+ * @param minute is the local minute
+ * @param second is the local second
+ * @return the write position after the field
+ */
+char* RecordFormatter::putField(char* out, char* end, const Token& token, const char* text, int hour, int minute, int second)
+{
+    int hour12 = hour % 12 == 0 ? 12 : hour % 12;
+
+    switch(token.field)
+    {
+    case Literal: return put(out, end, text + token.start, token.length);
+    case Day: return putNumber(out, end, day, 1);
+    case Day2: return putNumber(out, end, day, 2);
+    case DayShortName: return put(out, end, dayNames[0][dayOfWeek - 1].constData(), dayNames[0][dayOfWeek - 1].size());
+    case DayName: return put(out, end, dayNames[1][dayOfWeek - 1].constData(), dayNames[1][dayOfWeek - 1].size());
+    case Month: return putNumber(out, end, month, 1);
+    case Month2: return putNumber(out, end, month, 2);
+    case MonthShortName: return put(out, end, monthNames[0][month - 1].constData(), monthNames[0][month - 1].size());
+    case MonthName: return put(out, end, monthNames[1][month - 1].constData(), monthNames[1][month - 1].size());
+    case Year2: return putNumber(out, end, year % 100, 2);
+    case Year4: return putNumber(out, end, year, 4);
+    case Hour12: return putNumber(out, end, hour12, 1);
+    case Hour12Two: return putNumber(out, end, hour12, 2);
+    case Hour24: return putNumber(out, end, hour, 1);
+    case Hour24Two: return putNumber(out, end, hour, 2);
+    case Minute: return putNumber(out, end, minute, 1);
+    case Minute2: return putNumber(out, end, minute, 2);
+    case Second: return putNumber(out, end, second, 1);
+    case Second2: return putNumber(out, end, second, 2);
+    case AmPm: return hour < 12 ? put(out, end, amText.constData(), amText.size()) : put(out, end, pmText.constData(), pmText.size());
+    case AmPmLower: return hour < 12 ? put(out, end, amLower.constData(), amLower.size()) : put(out, end, pmLower.constData(), pmLower.size());
+    }
+
+    return out;
+}
+
+/**
+ * Writes everything of the bracketed start time that stays the same for an hour into hourText,
+ * leaving only the minute and second fields to be written for each record
+ *
+ * @param start is the start time of the hour (seconds since the epoch)
+ * @param hour is the local hour, 0 - 23
+ */
+void RecordFormatter::renderHour(qint64 start, int hour)
+{
+    char* out = hourText;
+    char* end = hourText + BUFFER_SIZE;
+
+    hourPattern.clear();
+    hourStart = start;
+
+    Token text;
+    text.field = Literal;
+    text.start = 0;
+    out = put(out, end, "[", 1);
+
+    for(const Token& token : pattern){
+        if(token.field >= Minute && token.field <= Second2){
+            text.length = (int)(out - hourText) - text.start;
+            if(text.length > 0){ hourPattern.push_back(text); }
+            hourPattern.push_back(token);
+            text.start = (int)(out - hourText);
+        }else{
+            out = putField(out, end, token, literals.constData(), hour, 0, 0);
+        }
+    }
+
+    out = put(out, end, "]", 1);
+    text.length = (int)(out - hourText) - text.start;
+    if(text.length > 0){ hourPattern.push_back(text); }
+}
+
+/**
+ * Writes the text of a record into the reused buffer
+ *
+ * @param record is the record to write
+ * @param length receives the number of bytes written
+ * @return the UTF-8 text, valid until the next call
+ */
+const char* RecordFormatter::format(const SessionRecord& record, int* length)
+{
+    char* out = buffer;
+    char* end = buffer + BUFFER_SIZE;
+
+    cacheWindow(record.startTime);
+    int offset = (int)(record.startTime - windowStart);
+    int minute = offset / 60 % 60;
+    int second = offset % 60;
+
+    //Windows start on the hour
+    qint64 start = record.startTime - minute * 60 - second;
+    if(start != hourStart){
+        renderHour(start, firstHour + offset / 3600);
+    }
+
+    //Start time in the locale's short format
+    for(const Token& token : hourPattern){
+        out = putField(out, end, token, hourText, 0, minute, second);
+    }
+
+    out = put(out, end, ID_LABEL.text, ID_LABEL.length);
+    out = putNumber(out, end, record.id, 1);
+
+    out = put(out, end, DURATION_LABEL.text, DURATION_LABEL.length);
+    out = putNumber(out, end, record.duration, 1);
+    out = put(out, end, MINUTES_LABEL.text, MINUTES_LABEL.length);
+
+    if(record.waveform < 3){
+        out = put(out, end, WAVEFORM_LABELS[record.waveform].text, WAVEFORM_LABELS[record.waveform].length);
+    }
+    if(record.frequency < 3){
+        out = put(out, end, FREQUENCY_LABELS[record.frequency].text, FREQUENCY_LABELS[record.frequency].length);
+    }
+
+    out = put(out, end, POWER_LABEL.text, POWER_LABEL.length);
+    out = putNumber(out, end, record.powerLevel, 1);
+
+    *length = (int)(out - buffer);
+    return buffer;
+}
+
+/**
+ * Text of a record as a QString, the only allocation is the QString itself
+ *
+ * @param record is the record to write
+ * @return the text of the record
+ */
+QString RecordFormatter::toString(const SessionRecord& record)
+{
+    int length;
+    const char* text = format(record, &length);
+    return QString::fromUtf8(text, length);
+}
@@ -0,0 +1,79 @@
+#ifndef RECORDFORMATTER_H
+#define RECORDFORMATTER_H
+
+#include <QByteArray>
+#include <QString>
+#include <vector>
+
+#include "sessionrecord.h"
+
+/*
+Class: RecordFormatter
+
+Purpose: This class writes the text of recorded sessions for the records tab, without allocating.
+
+Usage: Produces the same text as the records tab always showed, e.g.
+       "[1/2/23 10:00 AM]\nID: 0, Duration: 20:00, Waveform: Alpha, Freq: 0.5Hz, Powerlevel: 2"
+        - the text is written into one buffer that is reused for every record
+        - the waveform and frequency labels come from constexpr tables
+        - the locale's short date/time pattern is read and split into fields once, when the
+          formatter is made, instead of being looked up and parsed for every record
+        - the local date of the last record is cached, so the records of one day only need
+          arithmetic for their time (one hour on the days the clocks change)
+        - everything but the minutes and seconds is written once per hour, so a record only
+          copies that text and writes its own numbers
+       format() returns the UTF-8 text, valid until the next call. toString() wraps it in a QString.
+*/
+
+class RecordFormatter
+{
+public:
+    RecordFormatter(const QString& datePattern = QString());
+    ~RecordFormatter();
+
+    const char* format(const SessionRecord& record, int* length);   //Write the text of a record, returns the buffer
+    QString toString(const SessionRecord& record);                  //Text of a record as a QString
+
+private:
+    //Fields of a date/time pattern
+    enum Field { Literal, Day, Day2, DayShortName, DayName, Month, Month2, MonthShortName, MonthName,
+                 Year2, Year4, Hour12, Hour12Two, Hour24, Hour24Two, Minute, Minute2, Second, Second2, AmPm, AmPmLower };
+
+    //One field of the date/time pattern
+    struct Token
+    {
+        Field field;        //What to write
+        int start;          //Literal only: first byte in literals
+        int length;         //Literal only: number of bytes
+    };
+
+    static const int BUFFER_SIZE = 512;
+
+    std::vector<Token> pattern;             //The date/time pattern, split into fields
+    QByteArray literals;                    //Text of the literal fields
+    QByteArray amText;                      //The locale's AM text
+    QByteArray pmText;                      //The locale's PM text
+    QByteArray amLower;                     //The locale's AM text, lower case
+    QByteArray pmLower;                     //The locale's PM text, lower case
+    QByteArray monthNames[2][12];           //Short and long month names
+    QByteArray dayNames[2][7];              //Short and long day names (Monday first)
+    char buffer[BUFFER_SIZE];               //The text of the last record
+
+    //Local time of the window (a day, or an hour) holding the last record
+    qint64 windowStart;                     //Start time of the cached window (seconds since the epoch)
+    int windowLength;                       //Length of the cached window in seconds, 0 before the first lookup
+    int year, month, day, dayOfWeek;        //Local date of the cached window
+    int firstHour;                          //Local hour at the start of the cached window
+
+    //Bracketed start time of the hour holding the last record
+    qint64 hourStart;                       //Start time of the rendered hour (seconds since the epoch)
+    std::vector<Token> hourPattern;         //Literals of hourText, minute and second fields
+    char hourText[BUFFER_SIZE];             //Text of every field but the minutes and seconds
+
+    void parse(const QString& datePattern); //Split a date/time pattern into fields
+    void cacheWindow(qint64 startTime);     //Look up the local date of a time
+    void renderHour(qint64 start, int hour);//Write the text of the fields that stay the same for an hour
+    char* putField(char* out, char* end, const Token& token, const char* text, int hour, int minute, int second);   //Write one field
+};
+
+#endif // RECORDFORMATTER_H
@@ -0,0 +1,290 @@
+#include "recordindex.h"
+
+#include <algorithm>
+
+/**
+ * Checks a record against every condition of the query
+ *
+ * @param record is the record to check
+ * @return true if the record meets every condition
+ */
+bool RecordQuery::matches(const SessionRecord& record) const
+{
+    return record.startTime >= from && record.startTime < to
+            && (waveform < 0 || record.waveform == waveform)
+            && (frequency < 0 || record.frequency == frequency)
+            && record.duration >= minDuration && record.duration <= maxDuration
+            && record.powerLevel >= minPowerLevel && record.powerLevel <= maxPowerLevel;
+}
+
+
+/**
+ * All entries of some posting list parts, in ascending order
+ *
+ * @param slices are the parts, each in ascending order
+ * @return the merged entries
+ */
+static std::vector<quint32> merge(const std::vector<std::pair<const quint32*, const quint32*>>& slices)
+{
+    std::size_t size = 0;
+    for(const std::pair<const quint32*, const quint32*>& part : slices){
+        size += part.second - part.first;
+    }
+
+    std::vector<quint32> merged;
+    merged.reserve(size);
+    for(const std::pair<const quint32*, const quint32*>& part : slices){
+        std::size_t middle = merged.size();
+        merged.insert(merged.end(), part.first, part.second);
+        if(middle > 0){
+            std::inplace_merge(merged.begin(), merged.begin() + middle, merged.end());
+        }
+    }
+    return merged;
+}
+
+
+/**
+ * Entries found in both of two ascending lists. Written without branches on the
+ * values, the lists of two conditions interleave too randomly to predict.
+ *
+ * @param a is the first list, in ascending order
+ * @param b is the second list, in ascending order
+ * @return the common entries, in ascending order
+ */
+static std::vector<quint32> intersect(const std::vector<quint32>& a, const std::vector<quint32>& b)
+{
+    std::vector<quint32> both(std::min(a.size(), b.size()) + 1);
+    std::size_t i = 0, j = 0, k = 0;
+
+    while(i < a.size() && j < b.size()){
+        quint32 x = a[i], y = b[j];
+        both[k] = x;
+        k += x == y;
+        i += x <= y;
+        j += y <= x;
+    }
+
+    both.resize(k);
+    return both;
+}
+
+
+/**
+ * Constructor for the RecordIndex. Nothing is indexed until the first query or update().
+ *
+ * @param store is the record store to index
+ */
+RecordIndex::RecordIndex(RecordStore* store)
+{
+    this->store = store;
+    this->indexed = 0;
+    this->timeOrdered = true;
+}
+
+/**
+ * Deconstructor for the RecordIndex
+ */
+RecordIndex::~RecordIndex()
+{
+
+}
+
+/**
+ * Adds the records that were added to the store since the last update to the posting lists
+ */
+void RecordIndex::update()
+{
+    qint64 total = store->count();
+
+    for(; indexed < total; indexed++){
+        const SessionRecord& record = store->at(indexed);
+
+        //A clock change can make a record start before the previous one, time ranges are then scanned
+        if(indexed > 0 && record.startTime < store->at(indexed - 1).startTime){
+            timeOrdered = false;
+        }
+
+        if(record.waveform < 3 && record.frequency < 3){
+            byCombination[record.waveform * 3 + record.frequency].push_back((quint32)indexed);
+        }
+        byDuration[record.duration < MAX_DURATION ? record.duration : MAX_DURATION].push_back((quint32)indexed);
+        if(record.powerLevel <= 10){
+            byPowerLevel[record.powerLevel].push_back((quint32)indexed);
+        }
+    }
+}
+
+/**
+ * Finds the record indexes that can hold records of the query's time range,
+ * by binary search on the start times of the store
+ *
+ * @param query is the query
+ * @param begin receives the first record index of the range
+ * @param end receives the record index after the range
+ */
+void RecordIndex::timeRange(const RecordQuery& query, quint32& begin, quint32& end)
+{
+    begin = 0;
+    end = (quint32)indexed;
+
+    if(!timeOrdered){ return; }
+
+    //First record starting at or after from
+    quint32 low = 0, high = (quint32)indexed;
+    while(low < high){
+        quint32 middle = low + (high - low) / 2;
+        if(store->at(middle).startTime < query.from){ low = middle + 1; } else { high = middle; }
+    }
+    begin = low;
+
+    //First record starting at or after to
+    high = (quint32)indexed;
+    while(low < high){
+        quint32 middle = low + (high - low) / 2;
+        if(store->at(middle).startTime < query.to){ low = middle + 1; } else { high = middle; }
+    }
+    end = low;
+}
+
+/**
+ * Adds the part of a posting list between two record indexes to the postings of a condition
+ *
+ * @param postings receives the part
+ * @param list is the posting list, in ascending order
+ * @param begin is the first record index to include
+ * @param end is the record index after the last one to include
+ */
+void RecordIndex::addList(Postings& postings, const std::vector<quint32>& list, quint32 begin, quint32 end)
+{
+    const quint32* first = std::lower_bound(list.data(), list.data() + list.size(), begin);
+    const quint32* last = std::lower_bound(first, list.data() + list.size(), end);
+
+    postings.slices.push_back(std::make_pair(first, last));
+    postings.size += last - first;
+}
+
+/**
+ * Collects the posting lists of every condition of the query that has an index
+ *
+ * @param query is the query
+ * @param begin is the first record index of the time range
+ * @param end is the record index after the time range
+ * @param conditions receives the postings of each indexed condition
+ */
+void RecordIndex::postings(const RecordQuery& query, quint32 begin, quint32 end, std::vector<Postings>& conditions)
+{
+    Postings postings;
+
+    //Waveform/frequency
+    if(query.waveform >= 0 || query.frequency >= 0){
+        postings.slices.clear();
+        postings.size = 0;
+        postings.exact = true;
+        for(int w = 0; w < 3; w++){
+            for(int f = 0; f < 3; f++){
+                if((query.waveform < 0 || query.waveform == w) && (query.frequency < 0 || query.frequency == f)){
+                    addList(postings, byCombination[w * 3 + f], begin, end);
+                }
+            }
+        }
+        conditions.push_back(postings);
+    }
+
+    //Duration, the last list holds every longer duration too so it is only exact without an upper bound
+    if(query.minDuration > 0 || query.maxDuration < 0xffff){
+        int low = std::max(0, std::min(query.minDuration, MAX_DURATION));
+        int high = std::min(query.maxDuration, MAX_DURATION);
+        postings.slices.clear();
+        postings.size = 0;
+        postings.exact = query.minDuration <= MAX_DURATION && (query.maxDuration < MAX_DURATION || query.maxDuration >= 0xffff);
+        for(int d = low; d <= high; d++){
+            addList(postings, byDuration[d], begin, end);
+        }
+        conditions.push_back(postings);
+    }
+
+    //Power level
+    if(query.minPowerLevel > 0 || query.maxPowerLevel < 10){
+        postings.slices.clear();
+        postings.size = 0;
+        postings.exact = true;
+        for(int p = std::max(0, query.minPowerLevel); p <= std::min(10, query.maxPowerLevel); p++){
+            addList(postings, byPowerLevel[p], begin, end);
+        }
+        conditions.push_back(postings);
+    }
+}
+
+/**
+ * Finds every record that matches a query. Starts from the smallest set of candidates
+ * (a posting list or the time range) and intersects it with the posting lists of the other
+ * conditions, records are only read for the conditions no list answers exactly.
+ *
+ * @param query is the query
+ * @return the indexes of the matching records in the store, oldest first
+ */
+std::vector<quint32> RecordIndex::find(const RecordQuery& query)
+{
+    update();
+
+    std::vector<quint32> found;
+    quint32 begin, end;
+    timeRange(query, begin, end);
+    if(begin >= end){ return found; }
+
+    std::vector<Postings> conditions;
+    postings(query, begin, end, conditions);
+    std::sort(conditions.begin(), conditions.end(),
+              [](const Postings& a, const Postings& b) { return a.size < b.size; });
+
+    //The time range alone is the smallest candidate set: check every record in it
+    if(conditions.empty() || (qint64)(end - begin) <= conditions[0].size){
+        bool check = !timeOrdered || !conditions.empty();
+        for(quint32 i = begin; i < end; i++){
+            if(!check || query.matches(store->at(i))){ found.push_back(i); }
+        }
+        return found;
+    }
+
+    found = merge(conditions[0].slices);
+    bool check = !timeOrdered || !conditions[0].exact;
+
+    //Intersect with the other lists while they are not much larger than the candidates,
+    //reading the few remaining records is cheaper than that
+    for(std::size_t c = 1; c < conditions.size(); c++){
+        if(!conditions[c].exact || conditions[c].size > 32 * (qint64)found.size()){
+            check = true;
+            continue;
+        }
+
+        found = intersect(found, merge(conditions[c].slices));
+    }
+
+    if(check){
+        std::size_t kept = 0;
+        for(std::size_t i = 0; i < found.size(); i++){
+            if(query.matches(store->at(found[i]))){ found[kept++] = found[i]; }
+        }
+        found.resize(kept);
+    }
+
+    return found;
+}
+
+/**
+ * Counts the records that match a query
+ *
+ * @param query is the query
+ * @return the number of matching records
+ */
+qint64 RecordIndex::count(const RecordQuery& query)
+{
+    return (qint64)find(query).size();
+}
+
+/**
+ * Get the number of records indexed so far
+ * @return the number of indexed records
+ */
+qint64 RecordIndex::getIndexedCount(){ return indexed; }
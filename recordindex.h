@@ -0,0 +1,92 @@
+#ifndef RECORDINDEX_H
+#define RECORDINDEX_H
+
+#include <QtGlobal>
+#include <vector>
+
+#include "recordstore.h"
+
+/*
+Struct: RecordQuery
+
+Purpose: Conditions on recorded sessions, all of which a record must meet to be found.
+
+Usage: Every condition starts out as "any". Set only the ones to filter on, e.g.
+       all 77Hz Gamma sessions in March over 40 minutes:
+           RecordQuery query;
+           query.from = March 1st; query.to = April 1st;
+           query.waveform = 2; query.frequency = 1;
+           query.minDuration = 41;
+*/
+
+struct RecordQuery
+{
+    qint64 from = 0;                    //Earliest start time (seconds since the epoch, included)
+    qint64 to = 0x7fffffffffffffffLL;   //Latest start time (excluded)
+    int waveform = -1;                  //0 - Alpha, 1 - Beta, 2 - Gamma, -1 for any
+    int frequency = -1;                 //0 - 0.5Hz, 1 - 77Hz, 2 - 100Hz, -1 for any
+    int minDuration = 0;                //Shortest duration (included)
+    int maxDuration = 0xffff;           //Longest duration (included)
+    int minPowerLevel = 0;              //Lowest power level (included)
+    int maxPowerLevel = 10;             //Highest power level (included)
+
+    bool matches(const SessionRecord& record) const;    //Whether a record meets every condition
+};
+
+
+/*
+Class: RecordIndex
+
+Purpose: This class answers RecordQuery searches over a RecordStore without scanning every record.
+
+Usage: Keeps secondary indexes on the records of the store, each a posting list of record
+       indexes in ascending (oldest first) order:
+        - one list per waveform/frequency combination (9 lists)
+        - one list per duration (0 - 60, longer durations share the last list)
+        - one list per power level (0 - 10)
+       Records are stored in the order they were made, so a start time range is found by binary
+       search on the store itself. A query restricts each list it could use to that range
+       (binary search again), starts from the smallest set of candidates and intersects it with
+       the lists of the other conditions. Records are only read for conditions that no list
+       answers exactly.
+       The index catches up with the store on its own at the start of every query: the first
+       query indexes the whole history once, later ones only the records added since (O(1) each).
+*/
+
+class RecordIndex
+{
+public:
+    RecordIndex(RecordStore* store);
+    ~RecordIndex();
+
+    void update();                                              //Index the records added to the store since the last update
+    std::vector<quint32> find(const RecordQuery& query);        //Indexes of the matching records, oldest first
+    qint64 count(const RecordQuery& query);                     //Number of matching records
+
+    //Getters
+    qint64 getIndexedCount();           //Number of records indexed so far
+
+    static const int MAX_DURATION = 60; //Longest duration with its own list
+
+private:
+    RecordStore* store;                                 //Holds the records
+    qint64 indexed;                                     //Records 0 to indexed - 1 are in the lists
+    bool timeOrdered;                                   //Whether start times never decrease with the record index
+    std::vector<quint32> byCombination[9];              //Records of each waveform * 3 + frequency
+    std::vector<quint32> byDuration[MAX_DURATION + 1];  //Records of each duration
+    std::vector<quint32> byPowerLevel[11];              //Records of each power level
+
+    //Parts of the posting lists of one condition that fall in the time range of a query
+    struct Postings
+    {
+        std::vector<std::pair<const quint32*, const quint32*>> slices;  //Begin and end of each part
+        qint64 size;                                                    //Entries in all parts
+        bool exact;                                                     //Whether every entry meets the condition
+    };
+
+    void timeRange(const RecordQuery& query, quint32& begin, quint32& end);                    //Record indexes that can be in the time range
+    void postings(const RecordQuery& query, quint32 begin, quint32 end, std::vector<Postings>& conditions);  //Posting lists of each indexed condition
+    void addList(Postings& postings, const std::vector<quint32>& list, quint32 begin, quint32 end);         //Add the part of a list in a range
+};
+
+#endif // RECORDINDEX_H
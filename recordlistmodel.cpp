@@ -0,0 +1,52 @@
+#include "recordlistmodel.h"
+
+/**
+ * Constructor for the RecordListModel, shows every record already in the store
+ *
+ * @param store is the record store to show
+ * @param parent is the QObject parent of the model
+ */
+RecordListModel::RecordListModel(RecordStore* store, QObject *parent)
+    : QAbstractListModel(parent)
+{
+    this->store = store;
+    this->rows = (int)store->count();
+}
+
+/**
+ * Get the number of rows of the list
+ * @param parent is the parent index, a list has no children
+ * @return the number of records shown
+ */
+int RecordListModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : rows;
+}
+
+/**
+ * Formats the record of a row when the view needs it. Row 0 is the newest record.
+ *
+ * @param index is the row to format
+ * @param role is the kind of data the view asks for, only the display text is provided
+ * @return the text of the record
+ */
+QVariant RecordListModel::data(const QModelIndex &index, int role) const
+{
+    if(!index.isValid() || index.row() >= rows || role != Qt::DisplayRole){
+        return QVariant();
+    }
+
+    return formatter.toString(store->at(rows - 1 - index.row()));
+}
+
+/**
+ * Shows the record that was just added to the store as the first row
+ */
+void RecordListModel::recordAdded()
+{
+    if(store->count() <= rows){ return; }
+
+    beginInsertRows(QModelIndex(), 0, 0);
+    rows++;
+    endInsertRows();
+}
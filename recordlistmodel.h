@@ -0,0 +1,38 @@
+#ifndef RECORDLISTMODEL_H
+#define RECORDLISTMODEL_H
+
+#include <QAbstractListModel>
+
+#include "recordformatter.h"
+#include "recordstore.h"
+
+/*
+Class: RecordListModel
+
+Purpose: This class presents the records of a RecordStore to the records tab, newest first.
+
+Usage: Set it as the model of a QListView (with uniform item sizes, so the view never measures every row).
+       No row is stored or formatted up front: data() formats a record only when the view
+       paints it, straight from the store, with a RecordFormatter that reuses one buffer. Call recordAdded() after a record was added to the
+       store; it inserts a single row at the top, whatever the number of records.
+*/
+
+class RecordListModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    RecordListModel(RecordStore* store, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    void recordAdded();         //The store has a new record, show it at the top
+
+private:
+    RecordStore* store;         //Holds the records
+    int rows;                   //Number of records shown
+    mutable RecordFormatter formatter;  //Writes the text of the painted records
+};
+
+#endif // RECORDLISTMODEL_H
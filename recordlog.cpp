@@ -0,0 +1,136 @@
+#include "recordlog.h"
+
+#include <cstring>
+
+/**
+ * Magic bytes at the start of every record log
+ */
+static const char MAGIC[8] = { 'C', 'E', 'S', 'R', 'E', 'C', 'v', '1' };
+
+
+/**
+ * Constructor for the RecordLog. The file is not opened yet.
+ *
+ * @param path is the path of the log file
+ */
+RecordLog::RecordLog(const QString& path) : path(path), file(path)
+{
+    this->records = 0;
+}
+
+/**
+ * Deconstructor for the RecordLog, closes the file
+ */
+RecordLog::~RecordLog()
+{
+    close();
+}
+
+/**
+ * Opens the log, creating it with an empty header if it does not exist.
+ * A record cut short at the end of the file (e.g. a crash while writing) is dropped.
+ *
+ * @return false if the file can't be opened or is not a record log of this version
+ */
+bool RecordLog::open()
+{
+    if(!file.open(QIODevice::ReadWrite)){
+        return false;
+    }
+
+    char header[HEADER_SIZE];
+    quint32 version = VERSION;
+    quint32 recordSize = sizeof(SessionRecord);
+
+    //New log: write the header
+    if(file.size() == 0){
+        memcpy(header, MAGIC, 8);
+        memcpy(header + 8, &version, 4);
+        memcpy(header + 12, &recordSize, 4);
+
+        if(file.write(header, HEADER_SIZE) != HEADER_SIZE || !file.flush()){
+            file.close();
+            return false;
+        }
+
+        records = 0;
+        return true;
+    }
+
+    //Existing log: check the header
+    if(!file.seek(0) || file.read(header, HEADER_SIZE) != HEADER_SIZE || memcmp(header, MAGIC, 8) != 0){
+        file.close();
+        return false;
+    }
+
+    memcpy(&version, header + 8, 4);
+    memcpy(&recordSize, header + 12, 4);
+    if(version != VERSION || recordSize != sizeof(SessionRecord)){
+        file.close();
+        return false;
+    }
+
+    //Drop a partial record at the end
+    qint64 bytes = file.size() - HEADER_SIZE;
+    records = bytes / (qint64)sizeof(SessionRecord);
+    if(bytes % (qint64)sizeof(SessionRecord) != 0){
+        file.resize(HEADER_SIZE + records * (qint64)sizeof(SessionRecord));
+    }
+
+    return true;
+}
+
+/**
+ * Closes the log
+ */
+void RecordLog::close()
+{
+    file.close();
+}
+
+/**
+ * Adds a record at the end of the log and flushes it to the file
+ *
+ * @param record is the record to add
+ * @return false if the record could not be written
+ */
+bool RecordLog::append(const SessionRecord& record)
+{
+    if(!file.isOpen()){ return false; }
+
+    qint64 offset = HEADER_SIZE + records * (qint64)sizeof(SessionRecord);
+    if(!file.seek(offset) || file.write((const char*)&record, sizeof(SessionRecord)) != (qint64)sizeof(SessionRecord)){
+        return false;
+    }
+
+    file.flush();
+    records++;
+    return true;
+}
+
+/**
+ * Loads every record of the log with a single read
+ *
+ * @param records receives the records, oldest first
+ * @return false if the records could not be read
+ */
+bool RecordLog::readAll(std::vector<SessionRecord>& records)
+{
+    records.resize(this->records);
+    if(this->records == 0){ return true; }
+
+    qint64 bytes = this->records * (qint64)sizeof(SessionRecord);
+    return file.seek(HEADER_SIZE) && file.read((char*)records.data(), bytes) == bytes;
+}
+
+/**
+ * Get the number of records in the log
+ * @return the number of records
+ */
+qint64 RecordLog::count(){ return records; }
+
+/**
+ * Get the path of the log file
+ * @return the path
+ */
+QString RecordLog::getPath(){ return path; }
@@ -0,0 +1,46 @@
+#ifndef RECORDLOG_H
+#define RECORDLOG_H
+
+#include <QFile>
+#include <QString>
+#include <vector>
+
+#include "sessionrecord.h"
+
+/*
+Class: RecordLog
+
+Purpose: This class keeps the recorded therapy sessions of a device in an append-only binary file.
+
+Usage: The file starts with a 16 byte header (magic "CESRECv1", format version, record size)
+       followed by one fixed-width SessionRecord (24 bytes) per recorded session, oldest first.
+       Records are only ever appended, at the end of a session, and flushed right away.
+       A record cut short by a crash is dropped when the log is opened again.
+       readAll() loads the whole history with a single read.
+*/
+
+class RecordLog
+{
+public:
+    RecordLog(const QString& path);
+    ~RecordLog();
+
+    bool open();                                        //Open the log (created if missing), false if the file can't be used
+    void close();                                       //Close the log
+    bool append(const SessionRecord& record);           //Add a record at the end of the log
+    bool readAll(std::vector<SessionRecord>& records);  //Load every record, oldest first
+
+    //Getters
+    qint64 count();             //Number of records in the log
+    QString getPath();          //Path of the log file
+
+    static const int HEADER_SIZE = 16;      //Bytes before the first record
+    static const quint32 VERSION = 1;       //Version of the file format
+
+private:
+    QString path;               //Path of the log file
+    QFile file;                 //The log file, open for reading and writing
+    qint64 records;             //Number of complete records in the file
+};
+
+#endif // RECORDLOG_H
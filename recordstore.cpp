@@ -0,0 +1,113 @@
+#include "recordstore.h"
+
+/**
+ * Constructor for the RecordStore. The log is not opened yet.
+ *
+ * @param path is the path of the record log file
+ */
+RecordStore::RecordStore(const QString& path) : log(path), mapFile(path)
+{
+    this->mapping = nullptr;
+    this->mapped = nullptr;
+    this->mappedCount = 0;
+}
+
+/**
+ * Deconstructor for the RecordStore, unmaps and closes the log
+ */
+RecordStore::~RecordStore()
+{
+    close();
+}
+
+/**
+ * Opens the record log and maps the records it holds. Nothing is read here,
+ * so the time it takes does not depend on the number of records.
+ *
+ * @return false if the log can't be opened or mapped
+ */
+bool RecordStore::open()
+{
+    if(!log.open()){
+        return false;
+    }
+
+    tail.clear();
+    mappedCount = log.count();
+    if(mappedCount == 0){
+        return true;
+    }
+
+    //Map the header and the complete records, from the start of the file so the offset is page aligned
+    qint64 bytes = RecordLog::HEADER_SIZE + mappedCount * (qint64)sizeof(SessionRecord);
+    if(!mapFile.open(QIODevice::ReadOnly) || (mapping = mapFile.map(0, bytes)) == nullptr){
+        mapFile.close();
+        log.close();
+        mappedCount = 0;
+        return false;
+    }
+
+    mapped = (const SessionRecord*)(mapping + RecordLog::HEADER_SIZE);
+    return true;
+}
+
+/**
+ * Unmaps and closes the record log
+ */
+void RecordStore::close()
+{
+    if(mapping != nullptr){
+        mapFile.unmap(mapping);
+        mapping = nullptr;
+    }
+
+    mapFile.close();
+    log.close();
+    mapped = nullptr;
+    mappedCount = 0;
+    tail.clear();
+}
+
+/**
+ * Adds a record at the end of the log, and to the records of the store
+ *
+ * @param record is the record to add
+ * @return false if the record could not be written to the log
+ */
+bool RecordStore::append(const SessionRecord& record)
+{
+    if(!log.append(record)){
+        return false;
+    }
+
+    tail.push_back(record);
+    return true;
+}
+
+/**
+ * Get the number of records in the store
+ * @return the number of records
+ */
+qint64 RecordStore::count(){ return mappedCount + (qint64)tail.size(); }
+
+/**
+ * Get a record of the store without copying it
+ * @param index is the index of the record, 0 is the oldest, count() - 1 the newest
+ * @return the record
+ */
+const SessionRecord& RecordStore::at(qint64 index)
+{
+    return index < mappedCount ? mapped[index] : tail[index - mappedCount];
+}
+
+/**
+ * Get the number of records that come from the mapping
+ * @return the number of mapped records
+ */
+qint64 RecordStore::getMappedCount(){ return mappedCount; }
+
+/**
+ * Get the log the records are appended to
+ * @return the record log
+ */
+RecordLog* RecordStore::getLog(){ return &log; }
@@ -0,0 +1,50 @@
+#ifndef RECORDSTORE_H
+#define RECORDSTORE_H
+
+#include <QFile>
+#include <QString>
+#include <vector>
+
+#include "recordlog.h"
+#include "sessionrecord.h"
+
+/*
+Class: RecordStore
+
+Purpose: This class gives random access to every recorded session of a device without loading them.
+
+Usage: Opens the RecordLog of the device and memory maps the records already in it:
+        - opening costs the same for 10 records or 10 million, nothing is read or parsed
+        - at() returns a record straight from the mapping (zero copy), the OS only pages in
+          the parts of the file that are actually looked at
+        - new records are appended to the log and kept in a small in-memory tail,
+          so the mapping never has to change while the store is open
+       Records are indexed oldest first, 0 to count() - 1.
+*/
+
+class RecordStore
+{
+public:
+    RecordStore(const QString& path);
+    ~RecordStore();
+
+    bool open();                                    //Open the log and map its records, false if it can't be used
+    void close();                                   //Unmap and close the log
+    bool append(const SessionRecord& record);       //Add a record to the log and the store
+
+    //Getters
+    qint64 count();                                 //Number of records in the store
+    const SessionRecord& at(qint64 index);          //Record at index (0 is the oldest)
+    qint64 getMappedCount();                        //Number of records read from the mapping
+    RecordLog* getLog();                            //The log the records are appended to
+
+private:
+    RecordLog log;                          //Append side of the store
+    QFile mapFile;                          //Read only handle of the log file, for the mapping
+    uchar* mapping;                         //Mapping of the log file, nullptr if nothing is mapped
+    const SessionRecord* mapped;            //First record of the mapping
+    qint64 mappedCount;                     //Number of records in the mapping
+    std::vector<SessionRecord> tail;        //Records appended since the store was opened
+};
+
+#endif // RECORDSTORE_H
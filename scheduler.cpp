@@ -0,0 +1,321 @@
+#include "scheduler.h"
+
+/**
+ * Constructor for the Scheduler. The clock starts at 0 and its calendar time
+ * starts at the current time.
+ *
+ * @param mode is RealTime to follow the wall clock, VirtualTime to jump between deadlines
+ */
+Scheduler::Scheduler(Mode mode)
+{
+    this->mode = mode;
+    this->virtualNow = 0;
+    this->heldNow = -1;
+    this->speed = 1;
+    this->speedClock = 0;
+    this->speedWall = 0;
+    this->epoch = time(0);
+    this->wakeTimer = nullptr;
+
+    //In real time a single timer wakes up the scheduler at the next deadline
+    if(mode == RealTime){
+        wallClock.start();
+        wakeTimer = new QTimer();
+        wakeTimer->setTimerType(Qt::PreciseTimer);
+        wakeTimer->setSingleShot(true);
+        QObject::connect(wakeTimer, &QTimer::timeout, [this]() {
+            if(speed == MAX_SPEED){
+                runBatch();
+            }else{
+                wheel.fireUntil(now());
+            }
+            rearm();
+        });
+    }
+}
+
+/**
+ * Deconstructor for the Scheduler. Pending events are dropped without firing.
+ */
+Scheduler::~Scheduler()
+{
+    delete wakeTimer;
+}
+
+/**
+ * Schedules callback to be called once the clock reaches deadline
+ *
+ * @param deadline is the time of the clock in ms
+ * @param callback is called when the deadline is reached
+ * @return the id of the event, used to cancel it
+ */
+Scheduler::EventId Scheduler::schedule(qint64 deadline, Callback callback)
+{
+    EventId id = wheel.add(deadline, callback);
+
+    //Wake up earlier if this is the new next deadline
+    if(mode == RealTime && deadline <= nextDeadline()){
+        rearm();
+    }
+
+    return id;
+}
+
+/**
+ * Schedules callback to be called delay ms from now
+ *
+ * @param delay is the number of ms from now
+ * @param callback is called when the delay elapsed
+ * @return the id of the event, used to cancel it
+ */
+Scheduler::EventId Scheduler::scheduleIn(qint64 delay, Callback callback)
+{
+    return schedule(now() + delay, callback);
+}
+
+/**
+ * Cancels a pending event, it is taken out of the wheel
+ *
+ * @param id is the id returned when the event was scheduled
+ */
+void Scheduler::cancel(EventId id)
+{
+    wheel.remove(id);
+}
+
+/**
+ * Virtual time: jumps the clock to the next deadline and fires every event due at it
+ *
+ * @return false if no event was pending
+ */
+bool Scheduler::runNext()
+{
+    if(!hasPending()){ return false; }
+
+    //A deadline the clock was advanced past fires late, the clock never goes back
+    qint64 deadline = nextDeadline();
+    advanceTo(deadline);
+    wheel.fireUntil(deadline);
+    return true;
+}
+
+/**
+ * Virtual time: fires every event up to time in deadline order and leaves the clock at time
+ *
+ * @param time is the time in ms to run to
+ */
+void Scheduler::runUntil(qint64 time)
+{
+    while(hasPending() && nextDeadline() <= time){
+        runNext();
+    }
+
+    if(time > virtualNow){
+        virtualNow = time;
+    }
+}
+
+/**
+ * Virtual time: moves the clock forward to time. Events with earlier deadlines stay pending
+ * and fire late, as they would on a busy real time clock.
+ *
+ * @param time is the time in ms to move to, an earlier time does nothing
+ */
+void Scheduler::advanceTo(qint64 time)
+{
+    if(time > virtualNow){
+        virtualNow = time;
+    }
+}
+
+/**
+ * Virtual time: fires the next pending event only. The clock jumps to its deadline, or stays
+ * where it is if it is already past it (the event fires late).
+ *
+ * @return false if no event was pending
+ */
+bool Scheduler::fireNext()
+{
+    if(!hasPending()){ return false; }
+
+    advanceTo(nextDeadline());
+    wheel.fireFirst();
+    return true;
+}
+
+/**
+ * Keeps now() at the current time until releaseClock(), so everything an input or timer
+ * calls sees the same time in real time too
+ */
+void Scheduler::holdClock()
+{
+    heldNow = now();
+}
+
+/**
+ * Lets the clock run again after holdClock()
+ */
+void Scheduler::releaseClock()
+{
+    heldNow = -1;
+}
+
+/**
+ * Real time: runs the clock a number of times faster than the wall clock from now on, or as fast
+ * as possible. The clock carries on from its current time, every timer keeps its deadline.
+ *
+ * @param speed is the number of clock ms per wall clock ms (1 follows the wall clock), MAX_SPEED for as fast as possible
+ */
+void Scheduler::setSpeed(int speed)
+{
+    if(mode != RealTime || speed < 0){ return; }
+
+    speedClock = realNow() / 1000000;
+    speedWall = wallClock.nsecsElapsed();
+    this->speed = speed;
+
+    rearm();
+}
+
+/**
+ * Real time: how many times faster than the wall clock the clock runs
+ * @return the speed, MAX_SPEED if it runs as fast as possible
+ */
+int Scheduler::getSpeed(){ return speed; }
+
+/**
+ * Current time of the clock
+ * @return the time in ms since the scheduler was created (real time, times its speed) or the
+ *         virtual time, the time it is held at while it is held
+ */
+qint64 Scheduler::now()
+{
+    if(heldNow >= 0){ return heldNow; }
+
+    return mode == RealTime ? realNow() / 1000000 : virtualNow;
+}
+
+/**
+ * Current time of the clock with the resolution of the wall clock, to measure how late events fire
+ * @return the time in ns since the scheduler was created (real time, times its speed) or the virtual time in ns
+ */
+qint64 Scheduler::nowNanos()
+{
+    return mode == RealTime ? realNow() : virtualNow * 1000000;
+}
+
+/**
+ * How late the clock is past a deadline, to measure how late events fire. A faster real time
+ * clock runs speed times ahead of the wall clock, so its lateness is divided by the speed and
+ * reads the same at any speed. In virtual time and at MAX_SPEED the clock does not follow the
+ * wall clock, the lateness is the one of the clock.
+ *
+ * @param deadline is the time of the clock in ms
+ * @return the time since the deadline in ns, negative if it is not reached yet
+ */
+qint64 Scheduler::lateNanos(qint64 deadline)
+{
+    qint64 late = nowNanos() - deadline * 1000000;
+    if(mode == RealTime && speed > 1){ late /= speed; }
+
+    return late;
+}
+
+/**
+ * Real time: the wall clock time since the speed was last set, times the speed, after the
+ * time of the clock back then. Runs as fast as possible: the time the last batch jumped to.
+ *
+ * @return the time of the clock in ns
+ */
+qint64 Scheduler::realNow()
+{
+    if(speed == MAX_SPEED){ return speedClock * 1000000; }
+
+    return speedClock * 1000000 + (wallClock.nsecsElapsed() - speedWall) * speed;
+}
+
+/**
+ * Current time of the clock as a calendar time
+ * @return the epoch plus the elapsed clock time in seconds
+ */
+time_t Scheduler::currentTime()
+{
+    return epoch + (time_t)(now() / 1000);
+}
+
+/**
+ * Sets the calendar time of clock 0, allows repeatable record start times in virtual time
+ * @param epoch is the calendar time at which the clock was 0
+ */
+void Scheduler::setEpoch(time_t epoch){ this->epoch = epoch; }
+
+/**
+ * Calendar time of clock 0
+ * @return the calendar time at which the clock was at 0
+ */
+time_t Scheduler::getEpoch(){ return epoch; }
+
+/**
+ * Whether any event is still scheduled
+ * @return true if an event is pending
+ */
+bool Scheduler::hasPending()
+{
+    return !wheel.isEmpty();
+}
+
+/**
+ * Deadline of the next pending event. Only valid if hasPending() is true
+ * @return the deadline in ms
+ */
+qint64 Scheduler::nextDeadline()
+{
+    return wheel.nextDeadline();
+}
+
+/**
+ * Return the mode of the scheduler
+ * @return RealTime or VirtualTime
+ */
+Scheduler::Mode Scheduler::getMode(){ return mode; }
+
+/**
+ * Real time mode: sets the wake up timer to the wall clock time of the next deadline,
+ * or to the next pass of the event loop when running as fast as possible
+ */
+void Scheduler::rearm()
+{
+    if(wakeTimer == nullptr){ return; }
+
+    if(!hasPending()){
+        wakeTimer->stop();
+        return;
+    }
+
+    if(speed == MAX_SPEED){
+        wakeTimer->start(0);
+        return;
+    }
+
+    //Round up, waking up early only means waking up again
+    qint64 delay = nextDeadline() - now();
+    delay = delay > 0 ? (delay + speed - 1) / speed : 0;
+    wakeTimer->start((int)delay);
+}
+
+/**
+ * Real time mode at MAX_SPEED: jumps the clock from deadline to deadline and fires the events,
+ * for up to 8ms of wall clock time so the event loop (and the window) gets to run in between
+ */
+void Scheduler::runBatch()
+{
+    QElapsedTimer batch;
+    batch.start();
+
+    while(hasPending() && batch.nsecsElapsed() < 8000000){
+        if(nextDeadline() > speedClock){
+            speedClock = nextDeadline();
+        }
+        wheel.fireUntil(speedClock);
+    }
+}
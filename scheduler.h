@@ -0,0 +1,87 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <ctime>
+#include <QtGlobal>
+#include <QElapsedTimer>
+#include <QTimer>
+
+#include "timingwheel.h"
+
+/*
+Class: Scheduler
+
+Purpose: This class is the clock every timer of the CES device schedules against.
+         It keeps all pending timer deadlines in one TimingWheel, so starting and stopping
+         a timer costs the same with any number of devices.
+
+Usage: - Real time mode: the clock follows the wall clock and a single QTimer wakes
+         the scheduler up at the next deadline (needs a running Qt event loop)
+       - The real time clock can run faster than the wall clock (setSpeed()), or as fast as
+         possible: then it jumps from deadline to deadline for a few ms at a time and lets the
+         event loop run in between, so the program stays responsive
+       - Virtual time mode: nothing happens on its own, runNext()/runUntil() jump the
+         clock straight to the next deadline, so hours of simulation take microseconds
+       - Events with the same deadline fire in the order they were scheduled, so both
+         modes produce the same results
+       - Can be shared by any number of devices: their timers are nodes of its wheel, not Qt timers,
+         and the only timer the event loop knows of is the scheduler's own
+       - The clock can be held at its current time while an input or timer runs, so the
+         code it calls sees one time (EventLog does this, so replays see the same times)
+*/
+
+class Scheduler
+{
+public:
+    typedef TimingWheel::EventId EventId;           //Identifies a scheduled event, 0 is never used
+    typedef TimingWheel::Callback Callback;         //Called when an event's deadline is reached
+
+    enum Mode { RealTime, VirtualTime };
+
+    static const int MAX_SPEED = 0;                 //Speed of a real time clock that runs as fast as possible
+
+    Scheduler(Mode mode = VirtualTime);
+    ~Scheduler();
+
+    EventId schedule(qint64 deadline, Callback callback);   //Call callback once the clock reaches deadline (in ms)
+    EventId scheduleIn(qint64 delay, Callback callback);    //Call callback delay ms from now
+    void cancel(EventId id);                                //Cancel a pending event, does nothing if it already fired
+
+    bool runNext();                 //Virtual time: jump to the next deadline and fire its events. False if nothing is pending
+    void runUntil(qint64 time);     //Virtual time: fire every event up to time and leave the clock at time
+    void advanceTo(qint64 time);    //Virtual time: move the clock forward to time without firing anything
+    bool fireNext();                //Virtual time: fire the next event only, late if the clock is already past it. False if nothing is pending
+    void holdClock();               //Keep now() at the current time until releaseClock()
+    void releaseClock();            //Let the clock run again
+    void setSpeed(int speed);       //Real time: run the clock speed times faster than the wall clock (MAX_SPEED as fast as possible)
+    int getSpeed();                 //Real time: how many times faster than the wall clock the clock runs
+
+    //Getters/Setters
+    qint64 now();                   //Current time of the clock in ms
+    qint64 nowNanos();              //Current time of the clock in ns (whole ms in virtual time)
+    qint64 lateNanos(qint64 deadline);  //How late the clock is past deadline in wall clock ns (clock ns in virtual time and at MAX_SPEED)
+    time_t currentTime();           //Current time of the clock as a calendar time (for records)
+    void setEpoch(time_t epoch);    //Set the calendar time at which the clock was at 0
+    time_t getEpoch();              //Calendar time at which the clock was at 0
+    bool hasPending();              //Whether any event is still scheduled
+    qint64 nextDeadline();          //Deadline of the next pending event (only valid if hasPending())
+    Mode getMode();                 //Return the mode of the scheduler
+
+private:
+    Mode mode;                                                  //Real or virtual time
+    qint64 virtualNow;                                          //Current time in virtual mode
+    qint64 heldNow;                                             //Time the clock is held at, -1 if it runs
+    time_t epoch;                                               //Calendar time at clock 0
+    TimingWheel wheel;                                          //Pending deadlines and their callbacks
+    QElapsedTimer wallClock;                                    //Real time mode: time since the scheduler was created
+    int speed;                                                  //Real time mode: clock ms per wall clock ms, MAX_SPEED for as fast as possible
+    qint64 speedClock;                                          //Real time mode: time of the clock when the speed was set (the clock itself at MAX_SPEED)
+    qint64 speedWall;                                           //Real time mode: wall clock ns when the speed was set
+    QTimer* wakeTimer;                                          //Real time mode: wakes up the scheduler at the next deadline
+
+    void rearm();                   //Real time mode: set the wake up timer to the next deadline
+    void runBatch();                //Real time mode at MAX_SPEED: jump through the deadlines for a few ms
+    qint64 realNow();               //Real time mode: current time of the clock in ns, not held
+};
+
+#endif // SCHEDULER_H
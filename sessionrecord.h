@@ -0,0 +1,34 @@
+#ifndef SESSIONRECORD_H
+#define SESSIONRECORD_H
+
+#include <QtGlobal>
+
+/*
+Struct: SessionRecord
+
+Purpose: One recorded therapy session, in the fixed-width binary form it is stored in.
+
+Usage: Plain data, 24 bytes, no pointers, so records can be written to and read from
+       a file (or a mapped file) as they are:
+        - start time of the therapy (seconds since the epoch)
+        - ID of the record
+        - duration of the therapy
+        - waveform (0 - Alpha, 1 - Beta, 2 - Gamma), frequency (0 - 0.5Hz, 1 - 77Hz, 2 - 100Hz)
+          and last power level (0 - 10)
+       RecordFormatter builds the text shown in the records tab.
+*/
+
+struct SessionRecord
+{
+    qint64 startTime;       //Start time of the therapy (seconds since the epoch)
+    quint32 id;             //ID of the record
+    quint16 duration;       //Duration of the therapy (shown as minutes)
+    quint8 waveform;        //0 - Alpha, 1 - Beta, 2 - Gamma
+    quint8 frequency;       //0 - 0.5Hz, 1 - 77Hz, 2 - 100Hz
+    quint8 powerLevel;      //Last power level, 0 - 10 (50uA per level)
+    quint8 reserved[7];     //Zero, pads the record to 24 bytes
+};
+
+static_assert(sizeof(SessionRecord) == 24, "SessionRecord is stored as is, its size must not change");
+
+#endif // SESSIONRECORD_H
@@ -0,0 +1,78 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <atomic>
+#include <cstddef>
+
+/*
+Class: SpscRing
+
+Purpose: Lock-free queue between exactly one producer thread and one consumer thread.
+
+Usage: A fixed ring of Capacity slots (a power of 2). The producer calls tryPush(), the consumer
+       calls tryPop(), neither ever blocks or allocates:
+        - the producer only writes the tail, the consumer only writes the head
+        - each index lives on its own cache line so the two threads don't fight over it
+        - a full ring makes tryPush() fail instead of overwriting, an empty ring makes tryPop() fail
+*/
+
+template<typename T, std::size_t Capacity>
+class SpscRing
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of 2");
+
+public:
+    SpscRing() : head(0), tail(0) {}
+
+    /**
+     * Adds an item at the back of the ring. Producer thread only.
+     *
+     * @param item is copied into the ring
+     * @return false if the ring is full (the item is dropped)
+     */
+    bool tryPush(const T& item)
+    {
+        std::size_t back = tail.load(std::memory_order_relaxed);
+        if(back - head.load(std::memory_order_acquire) == Capacity){
+            return false;
+        }
+
+        items[back & (Capacity - 1)] = item;
+        tail.store(back + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Removes the item at the front of the ring. Consumer thread only.
+     *
+     * @param item receives the removed item
+     * @return false if the ring is empty
+     */
+    bool tryPop(T& item)
+    {
+        std::size_t front = head.load(std::memory_order_relaxed);
+        if(front == tail.load(std::memory_order_acquire)){
+            return false;
+        }
+
+        item = items[front & (Capacity - 1)];
+        head.store(front + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Get whether the ring holds no item. Exact from the consumer thread only.
+     * @return true if the ring is empty
+     */
+    bool isEmpty()
+    {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+private:
+    alignas(64) std::atomic<std::size_t> head;      //Index of the next item to pop, written by the consumer
+    alignas(64) std::atomic<std::size_t> tail;      //Index of the next slot to fill, written by the producer
+    alignas(64) T items[Capacity];                  //Items, index i is at items[i % Capacity]
+};
+
+#endif // SPSCRING_H
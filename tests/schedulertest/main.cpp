@@ -0,0 +1,499 @@
+#include <QCoreApplication>
+#include <QFile>
+#include <QTextStream>
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "cesdevice.h"
+#include "devicesnapshot.h"
+#include "eventlog.h"
+#include "eventreplay.h"
+#include "scheduler.h"
+#include "timingwheel.h"
+
+//Number of checks that failed so far
+static int failures = 0;
+
+/**
+ * Counts a check and prints it if it failed
+ *
+ * @param passed is the result of the check
+ * @param what describes the check
+ */
+static void check(bool passed, const QString& what)
+{
+    if(!passed){
+        failures++;
+        QTextStream(stdout) << "FAILED: " << what << "\n";
+    }
+}
+
+
+/*
+Struct: Reference
+
+Purpose: The events a TimingWheel should hold, kept in a plain vector: what fires up to a time
+         is found by sorting them by deadline and then by the order they were added.
+*/
+
+struct Reference
+{
+    struct Pending
+    {
+        qint64 due;                 //Deadline, or the wheel's time if it was added past it
+        quint64 order;              //Order it was added in
+        int tag;                    //What its callback records when it fires
+        TimingWheel::EventId id;    //Id the wheel gave it
+    };
+
+    std::vector<Pending> pending;   //Events added and not fired or removed
+    qint64 now = 0;                 //Time of the wheel
+    quint64 added = 0;              //Events added so far
+};
+
+/**
+ * Adds an event to the wheel and to the reference, its callback records its tag
+ *
+ * @param wheel is the wheel to add to
+ * @param reference is the reference to add to
+ * @param fired receives the tags of the events that fire
+ * @param deadline is the deadline of the event
+ * @return the id of the event
+ */
+static TimingWheel::EventId add(TimingWheel& wheel, Reference& reference, std::vector<int>& fired, qint64 deadline)
+{
+    int tag = (int)reference.added;
+    TimingWheel::EventId id = wheel.add(deadline, [&fired, tag]() { fired.push_back(tag); });
+
+    reference.pending.push_back(Reference::Pending{std::max(deadline, reference.now), reference.added++, tag, id});
+    return id;
+}
+
+/**
+ * Removes a pending event from the wheel and from the reference
+ *
+ * @param wheel is the wheel to remove from
+ * @param reference is the reference to remove from
+ * @param index is the index of the event in the reference
+ */
+static void remove(TimingWheel& wheel, Reference& reference, size_t index)
+{
+    check(wheel.remove(reference.pending[index].id), "remove a pending event");
+    check(!wheel.remove(reference.pending[index].id), "remove an event twice");
+
+    reference.pending.erase(reference.pending.begin() + index);
+}
+
+/**
+ * Fires the wheel up to a time and checks that exactly the events of the reference up to
+ * that time fired, in deadline order and in the order they were added for equal deadlines.
+ * Then checks the next deadline and the count of what is left.
+ *
+ * @param wheel is the wheel to fire
+ * @param reference is the reference it is checked against
+ * @param fired receives the tags of the events that fire
+ * @param time is the time to fire up to
+ * @param what names the check
+ */
+static void fireUntil(TimingWheel& wheel, Reference& reference, std::vector<int>& fired, qint64 time, const QString& what)
+{
+    std::sort(reference.pending.begin(), reference.pending.end(),
+              [](const Reference::Pending& a, const Reference::Pending& b){
+                  return a.due != b.due ? a.due < b.due : a.order < b.order;
+              });
+
+    std::vector<int> expected;
+    size_t due = 0;
+    while(due < reference.pending.size() && reference.pending[due].due <= time){
+        expected.push_back(reference.pending[due++].tag);
+    }
+    reference.pending.erase(reference.pending.begin(), reference.pending.begin() + due);
+    reference.now = std::max(reference.now, time);
+
+    fired.clear();
+    wheel.fireUntil(time);
+    check(fired == expected, what + ": fired events and order up to " + QString::number(time));
+    check(wheel.getCount() == (qint64)reference.pending.size(), what + ": pending count");
+    check(wheel.isEmpty() == reference.pending.empty(), what + ": isEmpty()");
+
+    if(!reference.pending.empty()){
+        qint64 next = reference.pending[0].due;
+        for(const Reference::Pending& pending : reference.pending){ next = std::min(next, pending.due); }
+        check(wheel.nextDeadline() == next, what + ": nextDeadline() " + QString::number(wheel.nextDeadline())
+                                            + " instead of " + QString::number(next));
+    }
+}
+
+/**
+ * Deadlines on both sides of the start of a slot of every level, added at once and fired
+ * one deadline at a time, then all at once: they fire in order after cascading down.
+ */
+static void testCascade()
+{
+    for(int jump = 0; jump < 2; jump++){
+        TimingWheel wheel;
+        Reference reference;
+        std::vector<int> fired;
+
+        for(int level = 0; level < 6; level++){
+            qint64 slot = (qint64)1 << (6 * level);
+            for(qint64 deadline : { slot - 1, slot, slot + 1, slot * 63, slot * 64 - 1, slot * 64 + 5 }){
+                add(wheel, reference, fired, deadline);
+                add(wheel, reference, fired, deadline);
+            }
+        }
+
+        if(jump){
+            fireUntil(wheel, reference, fired, (qint64)1 << 40, "cascade in one jump");
+            continue;
+        }
+
+        while(!wheel.isEmpty()){
+            fireUntil(wheel, reference, fired, wheel.nextDeadline(), "cascade deadline by deadline");
+        }
+    }
+}
+
+/**
+ * Events removed once they moved down a level (and once they are in their 1 ms slot) never
+ * fire, the other events of their slot still do.
+ */
+static void testRemoveCascaded()
+{
+    TimingWheel wheel;
+    Reference reference;
+    std::vector<int> fired;
+
+    //100000 ms is on level 2 at 0, on level 1 at 99000 and on level 0 at 99999
+    for(int i = 0; i < 4; i++){ add(wheel, reference, fired, 100000); }
+    add(wheel, reference, fired, 100001);
+
+    fireUntil(wheel, reference, fired, 99000, "remove cascaded");
+    remove(wheel, reference, 1);
+    fireUntil(wheel, reference, fired, 99999, "remove cascaded");
+    remove(wheel, reference, 0);
+    fireUntil(wheel, reference, fired, 100000, "remove cascaded");
+    fireUntil(wheel, reference, fired, 200000, "remove cascaded");
+}
+
+/**
+ * nextDeadline() finds a deadline hours ahead past empty slots of every level, again after
+ * an earlier deadline was removed, and is the wheel's time for a deadline already past.
+ */
+static void testNextDeadline()
+{
+    TimingWheel wheel;
+    Reference reference;
+    std::vector<int> fired;
+
+    TimingWheel::EventId late = add(wheel, reference, fired, 10800000);
+    check(wheel.nextDeadline() == 10800000, "nextDeadline() of a single event 3 hours ahead");
+
+    add(wheel, reference, fired, 70);
+    check(wheel.nextDeadline() == 70, "nextDeadline() of an earlier event");
+    remove(wheel, reference, 1);
+    check(wheel.nextDeadline() == 10800000, "nextDeadline() after the earlier event was removed");
+
+    fireUntil(wheel, reference, fired, 5000000, "next deadline");
+    check(wheel.nextDeadline() == 10800000, "nextDeadline() after firing up to before it");
+
+    add(wheel, reference, fired, 1000);
+    check(wheel.nextDeadline() == 5000000, "nextDeadline() of a deadline already past");
+    fireUntil(wheel, reference, fired, 5000000, "next deadline");
+    check(wheel.nextDeadline() == 10800000, "nextDeadline() once the late event fired");
+
+    check(wheel.remove(late), "remove the last event");
+    check(wheel.isEmpty(), "empty after the last event was removed");
+}
+
+/**
+ * Random adds (many on the same deadlines, some past the wheel's time), removes and jumps of
+ * every size, checked against the reference after every jump.
+ *
+ * @param seed is the seed of the random operations
+ */
+static void testRandom(int seed)
+{
+    std::mt19937 random(seed);
+    TimingWheel wheel;
+    Reference reference;
+    std::vector<int> fired;
+    QString what = "random seed " + QString::number(seed);
+
+    for(int i = 0; i < 20000; i++){
+        int operation = random() % 100;
+
+        if(operation < 50){
+            qint64 deadline;
+            if(operation < 10 && !reference.pending.empty()){
+                deadline = reference.pending[random() % reference.pending.size()].due;
+            }else if(operation < 13){
+                deadline = reference.now - (qint64)(random() % 1000);
+            }else{
+                qint64 distance = (qint64)1 << (random() % 34);
+                deadline = reference.now + distance + (qint64)(random() % distance);
+            }
+            add(wheel, reference, fired, deadline);
+
+        }else if(operation < 65){
+            if(!reference.pending.empty()){
+                remove(wheel, reference, random() % reference.pending.size());
+            }
+
+        }else{
+            qint64 distance = (qint64)1 << (random() % 24);
+            fireUntil(wheel, reference, fired, reference.now + (qint64)(random() % distance), what);
+        }
+    }
+
+    fireUntil(wheel, reference, fired, (qint64)1 << 40, what);
+}
+
+/**
+ * On the scheduler, timers with the same deadline fire in the order they were scheduled:
+ * whether they were scheduled hours before (and cascaded) or in the same ms, and after an
+ * event the clock was advanced past, which fires first.
+ */
+static void testEqualDeadlines()
+{
+    Scheduler scheduler(Scheduler::VirtualTime);
+    std::vector<int> fired;
+
+    for(int i = 0; i < 3; i++){
+        scheduler.schedule(5000, [&fired, i]() { fired.push_back(i); });
+    }
+
+    scheduler.runUntil(4990);
+    scheduler.schedule(4000, [&fired]() { fired.push_back(-1); });
+    for(int i = 3; i < 6; i++){
+        scheduler.schedule(5000, [&fired, &scheduler, i]() {
+            fired.push_back(i);
+
+            //Scheduled while its deadline fires, after every event already there
+            if(i == 3){ scheduler.schedule(5000, [&fired]() { fired.push_back(6); }); }
+        });
+    }
+
+    scheduler.runUntil(6000);
+    check(fired == std::vector<int>({ -1, 0, 1, 2, 3, 4, 5, 6 }), "equal deadlines fire in the order they were scheduled");
+}
+
+
+/*
+Struct: Input
+
+Purpose: One step of a random run of a device: an input, or a jump of its clock.
+*/
+
+struct Input
+{
+    int kind;           //Input 0 - 12, -1 to move the clock forward
+    int value;          //Value of the input
+    qint64 advance;     //How far the clock moves (ms)
+    bool fire;          //Whether the timers fire as the clock moves, late otherwise
+};
+
+/**
+ * Random inputs and clock jumps, so timers fire late and inputs come in between them
+ *
+ * @param seed is the seed of the inputs
+ * @param count is the number of inputs
+ * @return the inputs
+ */
+static std::vector<Input> randomInputs(int seed, int count)
+{
+    std::mt19937 random(seed);
+    std::vector<Input> inputs;
+
+    for(int i = 0; i < count; i++){
+        if(random() % 100 < 60){
+            inputs.push_back(Input{-1, 0, (qint64)(random() % 4000), random() % 3 != 0});
+        }else{
+            inputs.push_back(Input{(int)(random() % 13), (int)(random() % 1000), 0, false});
+        }
+    }
+
+    return inputs;
+}
+
+/**
+ * Gives an input to a device, or moves its clock
+ *
+ * @param device is the device
+ * @param scheduler is the clock of the device
+ * @param input is the input
+ */
+static void apply(CESDevice& device, Scheduler& scheduler, const Input& input)
+{
+    switch(input.kind){
+        case 0: device.pressPower(); break;
+        case 1: device.toggleRecording(); break;
+        case 2: device.changeSkinContact(input.value % 2); break;
+        case 3: device.changeDeviceEnabled(input.value % 4 != 0); break;
+        case 4: device.changePowerLevel(input.value % 760); break;
+        case 5: device.changeBatteryPercentage(input.value % 101); break;
+        case 6: device.inactivityUpdate(); break;
+        case 7: device.resetInactivity(); break;
+        case 8: device.increasePower(); break;
+        case 9: device.decreasePower(); break;
+        case 10: device.selectFrequency(input.value % 3); break;
+        case 11: device.selectWaveform(input.value % 3); break;
+        case 12: device.selectTherapyTime(input.value % 3); break;
+        default:{
+            qint64 time = scheduler.now() + input.advance;
+            scheduler.advanceTo(time);
+            while(input.fire && scheduler.hasPending() && scheduler.nextDeadline() <= time){
+                scheduler.fireNext();
+            }
+        }
+    }
+}
+
+
+/*
+Class: RunObserver
+
+Purpose: Keeps the records and battery percentages a device reports
+*/
+
+class RunObserver : public DeviceObserver
+{
+public:
+    void recordSaved(const SessionRecord& record) override { records.push_back(record); }
+    void batteryChanged(int percentage) override { battery.push_back(percentage); }
+
+    std::vector<SessionRecord> records;     //Records saved so far
+    std::vector<int> battery;               //Battery percentages reported so far
+};
+
+/**
+ * Whether two lists of records are the same, byte for byte
+ *
+ * @param a is the first list
+ * @param b is the second list
+ * @return true if they are the same
+ */
+static bool sameRecords(const std::vector<SessionRecord>& a, const std::vector<SessionRecord>& b)
+{
+    return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(SessionRecord)) == 0);
+}
+
+/**
+ * Logs a run like ces-headless --events does (recording on, skin contact, the therapy runs
+ * out) followed by random inputs, and replays the log file: the replay must match the log
+ * and save the same records and battery percentage.
+ *
+ * @param seed is the seed of the random inputs
+ * @param path is the file to log to
+ */
+static void testReplay(int seed, const QString& path)
+{
+    QString what = "replay seed " + QString::number(seed);
+    Scheduler scheduler(Scheduler::VirtualTime);
+    scheduler.setEpoch(1600000000 + seed);
+    RunObserver observer;
+    CESDevice device(&scheduler, &observer);
+    device.setNextRecordId(seed * 3);
+
+    EventLog log(&scheduler, path);
+    check(log.open(device.getNextRecordId()), what + ": open the log");
+    device.setEventLog(&log);
+
+    device.toggleRecording();
+    device.changeSkinContact(true);
+    while(observer.records.empty() && scheduler.runNext()){}
+
+    for(const Input& input : randomInputs(seed, 2000)){
+        apply(device, scheduler, input);
+    }
+    log.close();
+
+    EventReplay replay;
+    check(replay.load(path), what + ": load the log");
+    check(replay.run(), what + ": replay differs at event " + QString::number(replay.getDivergence()));
+    check(sameRecords(replay.getRecords(), observer.records), what + ": records");
+    check(replay.getBatteryPercentage() == (observer.battery.empty() ? 100 : observer.battery.back()), what + ": battery");
+}
+
+/**
+ * Runs random inputs on a device, saves a snapshot to a file part way, restores it into a
+ * new device and gives both the rest of the inputs: they must save the same records, report
+ * the same battery percentages and end in the same state.
+ *
+ * @param seed is the seed of the random inputs
+ * @param path is the file to save the snapshot to
+ */
+static void testSnapshot(int seed, const QString& path)
+{
+    QString what = "snapshot seed " + QString::number(seed);
+    std::vector<Input> inputs = randomInputs(seed, 2000);
+    size_t split = inputs.size() / 4 + seed * 37 % (inputs.size() / 2);
+
+    Scheduler original(Scheduler::VirtualTime);
+    original.setEpoch(1600000000);
+    RunObserver originalObserver;
+    CESDevice device(&original, &originalObserver);
+
+    for(size_t i = 0; i < split; i++){
+        apply(device, original, inputs[i]);
+    }
+    check(device.saveSnapshot().save(path), what + ": save");
+
+    DeviceSnapshot snapshot;
+    check(snapshot.load(path), what + ": load");
+    Scheduler restored(Scheduler::VirtualTime);
+    restored.setEpoch(1600000000);
+    restored.advanceTo(snapshot.time);
+    RunObserver restoredObserver;
+    CESDevice copy(&restored, &restoredObserver);
+    check(copy.restoreSnapshot(snapshot), what + ": restore");
+
+    originalObserver.records.clear();
+    originalObserver.battery.clear();
+    restoredObserver.records.clear();
+    restoredObserver.battery.clear();
+    for(size_t i = split; i < inputs.size(); i++){
+        apply(device, original, inputs[i]);
+        apply(copy, restored, inputs[i]);
+    }
+
+    check(sameRecords(originalObserver.records, restoredObserver.records), what + ": records");
+    check(originalObserver.battery == restoredObserver.battery, what + ": battery");
+
+    DeviceSnapshot end = device.saveSnapshot();
+    DeviceSnapshot copyEnd = copy.saveSnapshot();
+    check(memcmp(&end, &copyEnd, sizeof(DeviceSnapshot)) == 0, what + ": state at the end");
+}
+
+
+/**
+ * Checks the timing wheel and the scheduler against a sorted reference, then the event log
+ * replay and the snapshots of the device on random runs.
+ * Prints every check that failed and exits with 1 if any did.
+ */
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    testCascade();
+    testRemoveCascaded();
+    testNextDeadline();
+    for(int seed = 0; seed < 20; seed++){
+        testRandom(seed);
+    }
+    testEqualDeadlines();
+
+    QString eventsPath = "schedulertest.events";
+    QString snapshotPath = "schedulertest.snapshot";
+    for(int seed = 0; seed < 20; seed++){
+        testReplay(seed, eventsPath);
+        testSnapshot(seed, snapshotPath);
+    }
+    QFile::remove(eventsPath);
+    QFile::remove(snapshotPath);
+
+    QTextStream(stdout) << "failures: " << failures << "\n";
+    return failures == 0 ? 0 : 1;
+}
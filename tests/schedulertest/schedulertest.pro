@@ -0,0 +1,17 @@
+# Test of the timing wheel and the scheduler.
+# Checks them against a sorted reference, then the event log replay and the device snapshots.
+
+QT       -= gui
+QT       += core
+
+CONFIG += c++11 console testcase
+CONFIG -= app_bundle
+
+TARGET = schedulertest
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(../../ces-core.pri)
+
+SOURCES += \
+    main.cpp
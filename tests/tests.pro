@@ -0,0 +1,7 @@
+# Every test of the CES device simulation, built on its own (not part of ces-device.pro).
+# Each one links the core sources (ces-core.pri) with QtCore only, "make check" runs them.
+
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    schedulertest
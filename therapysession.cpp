@@ -1,5 +1,6 @@
 #include "therapysession.h"
 #include "cesdevice.h"
+#include "trace.h"
 
 /**
  * Constructor for the TherapySession class.
@@ -12,10 +13,18 @@ TherapySession::TherapySession(CESDevice* creator)
 {
     waveform = 0;
     frequency = 0;
-    duration = 20;
+    lastPowerLevel = 2;
+    length = 20000;
+    startClock = 0;
+    pausedTime = 0;
+    pausedAt = 0;
+    drift = 0;
     lastDuration = 20;
+    isRunning = false;
+    startTime = 0;
     parent = creator;
-    internalClock = new Timer(this);
+    internalClock = new Timer(creator->getScheduler(), [this]() { timerTimeout(); });
+    driftHistogram = nullptr;
 }
 
 
@@ -31,16 +40,21 @@ TherapySession::~TherapySession()
 /**
  * Starts a new therapy session.
  * Sets the start time for the therapy session to
- * the current time, intial powerlevel, duration
+ * the current time of the device's clock, intial powerlevel, duration
  * Starts timer for the therapy
  */
 void TherapySession::startSession()
 {
-    startTime = time(0);
+    TraceScope trace("startSession", "session");
+
+    startTime = parent->getScheduler()->currentTime();
+    startClock = parent->getScheduler()->now();
+    pausedTime = 0;
+    pausedAt = -1;
+    length = (qint64)lastDuration * 1000;
     internalClock->startTimer();
     lastPowerLevel = 2;
     isRunning = true;
-    duration = lastDuration;
     parent->setIsTreating(true);
 
 }
@@ -73,10 +87,28 @@ int TherapySession::getLastPowerLevel(){ return lastPowerLevel; }
 
 
 /**
- * Get the duration of the therapy in seconds
- * @return an int representing the number of seconds the therapy lasted
+ * Get the duration of the therapy in seconds, derived from the time left on the clock.
+ * A second that has started counts as a whole one, as the display shows it.
+ * @return an int representing the number of seconds left of the therapy
+ */
+int TherapySession::getDuration()
+{
+    qint64 remaining = getRemaining();
+    return remaining > 0 ? (int)((remaining + 999) / 1000) : 0;
+}
+
+/**
+ * Get the remaining time of the therapy: its length minus the time it has been running for
+ * @return the remaining time in ms, negative if the therapy ran past its length
  */
-int TherapySession::getDuration(){ return duration; }
+qint64 TherapySession::getRemaining(){ return length - getElapsed(); }
+
+/**
+ * Get how much longer than its length the last ended therapy ran, measured when its last
+ * tick came in, in wall clock time at any speed. 0 on a virtual time clock.
+ * @return the drift in ns
+ */
+qint64 TherapySession::getDrift(){ return drift; }
 
 /**
  * @brief Get the previously selected duration in seconds
@@ -129,11 +161,19 @@ void TherapySession::setLastPowerLevel(int level){ lastPowerLevel = level; }
 
 
 /**
- * Sets the duration for the therapy session
+ * Sets the duration for the therapy session. The therapy ends once it ran for that
+ * many more seconds, the ticks of a running countdown start again from now.
  *
  * @param seconds is the new duration of the therapy
  */
-void TherapySession::setDuration(int seconds){ duration = seconds; }
+void TherapySession::setDuration(int seconds)
+{
+    length = getElapsed() + (qint64)seconds * 1000;
+
+    if(pausedAt < 0 && internalClock->isActive()){
+        scheduleTick();
+    }
+}
 
 /**
  * Sets the previously selected duration of the Therapy
@@ -143,6 +183,64 @@ void TherapySession::setDuration(int seconds){ duration = seconds; }
  */
 void TherapySession::setLastDuration(int seconds){ lastDuration = seconds; }
 
+/**
+ * Sets whether the session is active, only used to restore a snapshot
+ * (startSession(), pauseSession() and resumeSession() also run the timer)
+ *
+ * @param choice is true if the session is active
+ */
+void TherapySession::setIsRunning(bool choice){ isRunning = choice; }
+
+/**
+ * Sets the start time of the therapy, only used to restore a snapshot
+ *
+ * @param time is the start time as a time_t object
+ */
+void TherapySession::setStartTime(time_t time){ startTime = time; }
+
+/**
+ * Sets the remaining time of the therapy and whether it counts down, only used to restore
+ * a snapshot (the timer is restored with the device's other timers)
+ *
+ * @param ms is the remaining time in ms
+ * @param counting is true if the countdown runs, false if it is paused or stopped
+ */
+void TherapySession::setRemaining(qint64 ms, bool counting)
+{
+    startClock = parent->getScheduler()->now();
+    pausedTime = 0;
+    pausedAt = counting ? -1 : startClock;
+    length = ms;
+}
+
+/**
+ * Sets where to record how much longer than its length every therapy ran
+ *
+ * @param histogram receives the drift in ns, nullptr for none
+ */
+void TherapySession::setDriftHistogram(LatencyHistogram* histogram){ driftHistogram = histogram; }
+
+/**
+ * Time the therapy has been running for: the time of the clock (or the time the countdown
+ * stopped at) since the start, less the time it spent paused
+ *
+ * @return the running time in ms
+ */
+qint64 TherapySession::getElapsed()
+{
+    qint64 until = pausedAt >= 0 ? pausedAt : parent->getScheduler()->now();
+    return until - startClock - pausedTime;
+}
+
+/**
+ * Sets the timer to the next whole second left of the therapy, it repeats every second from there
+ */
+void TherapySession::scheduleTick()
+{
+    qint64 partial = getRemaining() % 1000;
+    internalClock->startTimerAt(parent->getScheduler()->now() + (partial > 0 ? partial : 1000));
+}
+
 
 /**
  * Function for when the timer times out
@@ -151,22 +249,31 @@ void TherapySession::setLastDuration(int seconds){ lastDuration = seconds; }
  */
 void TherapySession::timerTimeout()
 {
-    //Decrement by 1 second
-    this->duration--;
+    TraceScope trace("timerTimeout", "timer");
+
+    //The display shows the seconds left on the clock
     parent->updateDisplay();
 
 
     //Stop at 0 seconds
-    if (this->duration <= 0)
+    if (getRemaining() <= 0)
     {
+        //How late the end came in, against the exact end of the therapy
+        Scheduler* scheduler = parent->getScheduler();
+        drift = scheduler->lateNanos(startClock + pausedTime + length);
+        if(driftHistogram != nullptr){ driftHistogram->record(drift); }
+
         //Stop the timer
-        this->internalClock->stopTimer();
+        stopSession();
 
         //End the session when timer end
-        int endofSession = lastDuration - duration;
+        int endofSession = lastDuration - getDuration();
         this->parent->stopSession(endofSession);
 
         this->isRunning = false;
+
+        //Reset the device for the next session
+        this->parent->finishSession();
     }
 }
 
@@ -175,9 +282,15 @@ void TherapySession::timerTimeout()
  */
 void TherapySession::pauseSession()
 {
+    TraceScope trace("pauseSession", "session");
+
     this->internalClock->stopTimer();
     this->isRunning = false;
 
+    //The countdown holds still until it resumes
+    if(pausedAt < 0){
+        pausedAt = parent->getScheduler()->now();
+    }
 }
 
 /**
@@ -185,6 +298,26 @@ void TherapySession::pauseSession()
  */
 void TherapySession::resumeSession()
 {
+    TraceScope trace("resumeSession", "session");
+
+    //The paused time does not count, the countdown carries on within the second it stopped in
+    if(pausedAt >= 0){
+        pausedTime += parent->getScheduler()->now() - pausedAt;
+        pausedAt = -1;
+    }
+
     this->isRunning = true;
-    this->internalClock->startTimer();
+    scheduleTick();
+}
+
+/**
+ * Stops the countdown where it is, the therapy ended. The remaining time stays as it was.
+ */
+void TherapySession::stopSession()
+{
+    this->internalClock->stopTimer();
+
+    if(pausedAt < 0){
+        pausedAt = parent->getScheduler()->now();
+    }
 }
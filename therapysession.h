@@ -3,6 +3,7 @@
 
 #include <ctime>
 #include <QTime>
+#include <latencyhistogram.h>
 #include <timer.h>
 
 //Forward declare parent
@@ -22,6 +23,12 @@ Usage: Keeps track of the current settings for a therapy session including:
         - whether or not the therapy was recorded
 
        Provides getters and setters for these statuses.
+
+       The countdown is not counted by the timer: the remaining time is the length of the therapy
+       minus the time of the clock since it started, less the time it spent paused. The timer only
+       wakes it up on every whole second left, to update the display and end the therapy, so a
+       late tick or a pause never adds to the treatment. How much longer than its length a therapy
+       ran when it ended (the drift) is kept, and recorded if a histogram is set.
 */
 
 class TherapySession
@@ -33,13 +40,16 @@ public:
     void startSession();        //Sets the start time for the session
     void pauseSession();        //Pause current therapy session
     void resumeSession();       //Resume a paused therapy session
+    void stopSession();         //Stop the countdown where it is (the therapy ended)
     void timerTimeout();        //Method called when the timer runs down
 
     //Getters
     int getWaveform();          //Return the selected waveform of the therapy
     int getFrequency();         //Return the selected frequency of the therapy
     int getLastPowerLevel();    //Return the last selected power level for the therapy
-    int getDuration();          //Return the duration of the therapy (in seconds)
+    int getDuration();          //Return the duration of the therapy (in seconds, rounded up)
+    qint64 getRemaining();      //Return the remaining time of the therapy (in ms)
+    qint64 getDrift();          //Return how much longer than its length the last ended therapy ran (in ns)
     int getLastDuration();      //Return the previously selected duration of the therapy (in seconds)
     bool getIsRunning();        //Return whether or not the session is active
     time_t getStartTime();      //Return the start time of the therapy
@@ -51,17 +61,29 @@ public:
     void setLastPowerLevel(int level);  //Set the last power level of the therapy
     void setDuration(int seconds);      //Set the duration of the therapy (in seconds)
     void setLastDuration(int seconds);  //Set the last duration selected to allow therapy to restart properly
+    void setIsRunning(bool choice);     //Set whether the session is active (to restore a snapshot)
+    void setStartTime(time_t time);     //Set the start time of the therapy (to restore a snapshot)
+    void setRemaining(qint64 ms, bool counting);    //Set the remaining time and whether it counts down (to restore a snapshot)
+    void setDriftHistogram(LatencyHistogram* histogram);    //Record the drift of every ended therapy (nullptr for none)
 
 private:
+    qint64 getElapsed();        //Time the therapy has been running for (in ms)
+    void scheduleTick();        //Set the timer to the next whole second left
+
     int waveform;           //The selected waveform for the therapy
     int frequency;          //The selected frequency for the therapy
     int lastPowerLevel;     //The last selected power level for the therapy
-    int duration;           //The duration of the therapy (in seconds)
+    qint64 length;          //Running time after which the therapy ends (in ms)
+    qint64 startClock;      //Time of the clock the therapy started at (in ms)
+    qint64 pausedTime;      //Time the therapy spent paused since it started (in ms)
+    qint64 pausedAt;        //Time of the clock the countdown stopped at, -1 while it counts down
+    qint64 drift;           //How much longer than its length the last ended therapy ran (in ns)
     int lastDuration;       //The previously selected duration (in seconds)
     bool isRunning;         //Whether or not the session is active
     time_t startTime;       //The start time for the therapy
     CESDevice* parent;      //The CESDevice that made the therapy session, only used for call backs (maybe wipe when recording is done NOT delete)
-    Timer* internalClock;   //A clock that keeps track of the seconds passing
+    Timer* internalClock;   //Wakes the therapy up on every whole second left
+    LatencyHistogram* driftHistogram;   //Receives the drift of every ended therapy, may be nullptr
 };
 
 #endif // THERAPYSESSION_H
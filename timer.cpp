@@ -1,17 +1,23 @@
 #include "timer.h"
-#include "therapysession.h"
 
 /**
- * Constructor for the Timer class. Initializes the qtimer and sets it up as a precise,
- * singleshot timer. Connects the slot for timeout of the timer as well.
+ * Constructor for the Timer class. The timer is stopped and repeating until started.
+ *
+ * @param scheduler is the clock the timer schedules against
+ * @param callback is called whenever the timer runs out
  */
-Timer::Timer(TherapySession* creator)
+Timer::Timer(Scheduler* scheduler, std::function<void()> callback)
 {
-    timer = new QTimer(this);
-    timer->setTimerType(Qt::PreciseTimer);
-    timer->setInterval(1000); //1sec
-    parent = creator;
-    connect(timer, &QTimer::timeout, this, &Timer::timerTimeout);
+    this->scheduler = scheduler;
+    this->callback = callback;
+    this->event = 0;
+    this->deadline = 0;
+    this->interval = 1000; //1sec
+    this->singleShot = false;
+    this->lateness = nullptr;
+    this->runTime = nullptr;
+    this->eventLog = nullptr;
+    this->eventKind = EventLog::TherapyTimer;
 }
 
 
@@ -20,16 +26,37 @@ Timer::Timer(TherapySession* creator)
  */
 Timer::~Timer()
 {
-    delete timer;
+    stopTimer();
 }
 
 
 /**
- * Starts or restarts the timer with 1 second
+ * Starts or restarts the timer
+ *
+ * @param interval is the time until the timer runs out in ms, 1 second by default
  */
-void Timer::startTimer()
+void Timer::startTimer(int interval)
 {
-    timer->start(1000);
+    stopTimer();
+
+    this->interval = interval;
+    deadline = scheduler->now() + interval;
+    event = scheduler->schedule(deadline, [this]() { timerTimeout(); });
+}
+
+
+/**
+ * Starts or restarts the timer so that it runs out at the given time of the scheduler's
+ * clock. A repeating timer keeps its interval after that.
+ *
+ * @param deadline is the time of the clock in ms
+ */
+void Timer::startTimerAt(qint64 deadline)
+{
+    stopTimer();
+
+    this->deadline = deadline;
+    event = scheduler->schedule(deadline, [this]() { timerTimeout(); });
 }
 
 
@@ -38,20 +65,107 @@ void Timer::startTimer()
  */
 void Timer::stopTimer()
 {
-    timer->stop();
+    if(event != 0){
+        scheduler->cancel(event);
+        event = 0;
+    }
+}
+
 
+/**
+ * Whether the timer is currently running
+ * @return true if the timer is running
+ */
+bool Timer::isActive()
+{
+    return event != 0;
 }
 
 
 /**
- * Slot method for when the timer times out
+ * Time of the scheduler's clock at which the timer runs out next
+ * @return the deadline in ms, -1 if the timer is stopped
  */
-void Timer::timerTimeout()
+qint64 Timer::getDeadline()
 {
-    parent->timerTimeout();
+    return event != 0 ? deadline : -1;
 }
 
-//Getters
-QTimer* Timer::getTimer() { return this->timer; }
+
+/**
+ * Scheduler event of the pending deadline. Events scheduled later have higher ids, so it tells
+ * which of two timers with the same deadline fires first.
+ * @return the event id, 0 if the timer is stopped
+ */
+Scheduler::EventId Timer::getEvent(){ return event; }
+
+
+/**
+ * Time between two deadlines of a repeating timer
+ * @return the interval in ms
+ */
+int Timer::getInterval(){ return interval; }
+
+
+/**
+ * Set the time between two deadlines of a repeating timer. A pending deadline does not move.
+ * @param interval is the interval in ms
+ */
+void Timer::setInterval(int interval){ this->interval = interval; }
 
 
+/**
+ * Set whether the timer stops after it ran out once
+ * @param choice is true for a single shot timer
+ */
+void Timer::setSingleShot(bool choice){ singleShot = choice; }
+
+
+/**
+ * Set where to record how late the timer fires and how long its callback runs
+ * @param lateness receives the time between the deadline and the call in wall clock ns at any speed, nullptr for none
+ * @param runTime receives the time the callback took in ns, nullptr for none
+ */
+void Timer::setLatency(LatencyHistogram* lateness, LatencyHistogram* runTime)
+{
+    this->lateness = lateness;
+    this->runTime = runTime;
+}
+
+
+/**
+ * Set where to log every time the timer fires
+ * @param log is the event log of the device, nullptr for none
+ * @param kind is what the timer is logged as
+ */
+void Timer::setEventLog(EventLog* log, EventLog::Kind kind)
+{
+    this->eventLog = log;
+    this->eventKind = kind;
+}
+
+
+/**
+ * Called by the scheduler when the timer runs out.
+ * A repeating timer schedules its next deadline one interval after this one
+ * (not after now) before calling back, so the callback can still stop it.
+ * Records how late the call is and how long the callback runs, and logs the call, if asked to.
+ */
+void Timer::timerTimeout()
+{
+    event = 0;
+
+    if(lateness != nullptr){
+        lateness->record(scheduler->lateNanos(deadline));
+    }
+
+    if(!singleShot){
+        deadline += interval;
+        event = scheduler->schedule(deadline, [this]() { timerTimeout(); });
+    }
+
+    //The callback may stop or restart the timer, the scopes only use their own copies of the histogram and log
+    EventScope logged(eventLog, eventKind);
+    LatencyScope timing(runTime);
+    callback();
+}
@@ -1,42 +1,56 @@
 #ifndef TIMER_H
 #define TIMER_H
 
-#include <QTimer>
-
-//Forward declare parent device:
-class TherapySession;//Prevents circular dependency
+#include <functional>
+#include "eventlog.h"
+#include "latencyhistogram.h"
+#include "scheduler.h"
 
 /*
 Class: Timer
 
 Purpose: This class serves as a representation of a timer that can be used by the CES device.
 
-Usage: Allows for extended use of the QTimer class including:
-        - starting/resetting the timer
+Usage: Schedules its deadlines against the device's Scheduler, so it runs in real or virtual time:
+        - starting/resetting the timer with an interval (repeating or single shot)
         - stopping the timer
 
-       Also provides slot method for when the timer expires.
+       Calls the callback it was created with whenever the timer expires.
+       Can record how late it fires (against its deadline) and how long its callback runs,
+       and log every time it fires in an EventLog.
 */
 
-class Timer : public QObject
+class Timer
 {
-    Q_OBJECT
 public:
-    Timer(TherapySession* creator);
+    Timer(Scheduler* scheduler, std::function<void()> callback);
     ~Timer();
 
-    void startTimer();              //Starts or restarts the timer
-    void stopTimer();               //Stops the timer
-
-    //Getter
-    QTimer* getTimer();             //Getter for the timer
-
-private slots:
-    void timerTimeout();            //Slot method for when the timer runs out
+    void startTimer(int interval = 1000);   //Starts or restarts the timer
+    void startTimerAt(qint64 deadline);     //Starts or restarts the timer to run out at the given time of the clock
+    void stopTimer();                       //Stops the timer
+    bool isActive();                        //Whether the timer is running
+    qint64 getDeadline();                   //Time of the clock at which the timer runs out next, -1 if it is stopped
+    Scheduler::EventId getEvent();          //Event of the pending deadline (later deadlines have higher ids), 0 if stopped
+    int getInterval();                      //Time between two deadlines in ms
+    void setInterval(int interval);         //Set the time between two deadlines in ms, used from the next deadline on
+    void setSingleShot(bool choice);        //Set whether the timer stops after it expired once
+    void setLatency(LatencyHistogram* lateness, LatencyHistogram* runTime); //Record how late it fires and how long the callback runs (nullptr for none)
+    void setEventLog(EventLog* log, EventLog::Kind kind);                   //Log every time it fires as kind (nullptr for none)
 
 private:
-    QTimer* timer;                  //Timer for the class (should end every 1 second)
-    TherapySession* parent;         //Therapy session that created this class
+    void timerTimeout();                    //Called by the scheduler when the timer runs out
+
+    Scheduler* scheduler;                   //Clock the timer schedules its deadlines against
+    std::function<void()> callback;         //Called whenever the timer runs out
+    Scheduler::EventId event;               //The pending deadline, 0 if the timer is stopped
+    qint64 deadline;                        //Time of the pending deadline
+    int interval;                           //Time between two deadlines in ms (should end every 1 second)
+    bool singleShot;                        //Whether the timer stops after it expired once
+    LatencyHistogram* lateness;             //Receives how late the timer fired in ns, may be nullptr
+    LatencyHistogram* runTime;              //Receives how long the callback ran in ns, may be nullptr
+    EventLog* eventLog;                     //Logs every time the timer fires, may be nullptr
+    EventLog::Kind eventKind;               //What the timer is logged as
 };
 
 #endif // TIMER_H
@@ -0,0 +1,401 @@
+#include "timingwheel.h"
+
+#include <algorithm>
+#include <QtAlgorithms>
+
+/**
+ * Distance from a slot to the next occupied slot of its level, going round the wheel
+ *
+ * @param bits is the occupied slots of the level, not 0
+ * @param index is the slot to start after
+ * @return 1 for the slot right after it, up to 64 for the slot itself (one turn later)
+ */
+static int offsetAfter(quint64 bits, int index)
+{
+    int shift = index + 1;
+    quint64 rotated = shift == 64 ? bits : (bits >> shift) | (bits << (64 - shift));
+    return (int)qCountTrailingZeroBits(rotated) + 1;
+}
+
+
+/**
+ * Constructor for the TimingWheel. It is empty and its time is 0.
+ */
+TimingWheel::TimingWheel()
+{
+    this->freeNode = NONE;
+    this->unsorted = 0;
+    this->time = 0;
+    this->sequence = 1;
+    this->count = 0;
+    this->cachedNext = -1;
+
+    std::fill(heads, heads + LEVELS * SLOTS, (int)NONE);
+    std::fill(tails, tails + LEVELS * SLOTS, (int)NONE);
+    std::fill(occupied, occupied + LEVELS, (quint64)0);
+}
+
+/**
+ * Adds an event. It takes a free node (or a new one) and links it into the slot of its deadline.
+ *
+ * @param deadline is the time in ms it fires at
+ * @param callback is called when it fires
+ * @return the id of the event, used to remove it. 0 if 2^24 events are already pending
+ */
+TimingWheel::EventId TimingWheel::add(qint64 deadline, Callback callback)
+{
+    int node;
+    if(freeNode != NONE){
+        node = freeNode;
+        freeNode = nodes[node].next;
+    }else{
+        if(nodes.size() >= ((size_t)1 << INDEX_BITS)){ return 0; }
+        node = (int)nodes.size();
+        nodes.push_back(Node());
+    }
+
+    Node& added = nodes[node];
+    added.deadline = deadline;
+    added.id = (sequence++ << INDEX_BITS) | (EventId)node;
+    added.callback = std::move(callback);
+    count++;
+    place(node);
+
+    //Still the next deadline unless this one is earlier
+    qint64 due = deadline > time ? deadline : time;
+    if(count == 1 || (cachedNext >= 0 && due < cachedNext)){
+        cachedNext = due;
+    }
+
+    return added.id;
+}
+
+/**
+ * Removes a pending event: it is unlinked from its slot and its node is freed
+ *
+ * @param id is the id returned when the event was added
+ * @return false if the event is not pending (it fired or was removed)
+ */
+bool TimingWheel::remove(EventId id)
+{
+    size_t node = (size_t)(id & (((EventId)1 << INDEX_BITS) - 1));
+    if(id == 0 || node >= nodes.size() || nodes[node].id != id){ return false; }
+
+    qint64 due = nodes[node].deadline > time ? nodes[node].deadline : time;
+    unlink((int)node);
+    release((int)node);
+
+    if(due <= cachedNext){
+        cachedNext = -1;
+    }
+
+    return true;
+}
+
+/**
+ * Moves the time of the wheel forward to time and fires every event it passes, in deadline order
+ * and in the order they were added on the same deadline. Events the callbacks add up to time fire too.
+ *
+ * @param time is the time in ms up to which events fire, an earlier time than the wheel's does nothing
+ */
+void TimingWheel::fireUntil(qint64 time)
+{
+    if(time < this->time){ return; }
+
+    do{
+        for(int slot = (int)(this->time & MASK); heads[slot] != NONE; slot = (int)(this->time & MASK)){
+            fire(first(slot));
+        }
+    }while(this->time < time && step(time));
+}
+
+/**
+ * Fires the next event only. The time of the wheel moves to its deadline (if it is not past it).
+ *
+ * @return false if no event was pending
+ */
+bool TimingWheel::fireFirst()
+{
+    if(count == 0){ return false; }
+
+    //Nothing is due before it, every step leads to it
+    qint64 next = nextDeadline();
+    while(time < next && step(next)){}
+
+    fire(first((int)(time & MASK)));
+    return true;
+}
+
+/**
+ * Whether no event is pending
+ * @return true if the wheel is empty
+ */
+bool TimingWheel::isEmpty(){ return count == 0; }
+
+/**
+ * Get the number of pending events
+ * @return the number of events
+ */
+qint64 TimingWheel::getCount(){ return count; }
+
+/**
+ * Deadline of the next event. Level 0 holds it if it is within 64 ms, otherwise the earliest event of
+ * the next occupied slot of each level is looked up. Kept until an event is fired or an earlier one changes.
+ *
+ * @return the deadline in ms, the wheel's time for an event that is past due. Only valid if !isEmpty()
+ */
+qint64 TimingWheel::nextDeadline()
+{
+    if(count == 0 || cachedNext >= 0){ return count == 0 ? time : cachedNext; }
+
+    //The rest of the current 64 ms of level 0
+    quint64 current = occupied[0] & (~(quint64)0 << (time & MASK));
+    if(current != 0){
+        cachedNext = (time & ~(qint64)MASK) + qCountTrailingZeroBits(current);
+        return cachedNext;
+    }
+
+    //Level 0 slots before the current one hold the next 64 ms
+    qint64 next = -1;
+    if(occupied[0] != 0){
+        next = (time | MASK) + 1 + qCountTrailingZeroBits(occupied[0]);
+    }
+
+    for(int level = 1; level < LEVELS; level++){
+        quint64 bits = occupied[level];
+        int index = (int)((time >> (SLOT_BITS * level)) & MASK);
+
+        while(bits != 0){
+            int slot = level * SLOTS + ((index + offsetAfter(bits, index)) & MASK);
+            qint64 deadline = earliest(slot);
+            if(next < 0 || deadline < next){ next = deadline; }
+
+            //Deadlines beyond the reach of the last level are not in slot order, check every slot
+            if(level < LEVELS - 1){ break; }
+            bits &= ~((quint64)1 << (slot & MASK));
+        }
+    }
+
+    cachedNext = next;
+    return next;
+}
+
+/**
+ * Links a node into the slot of its deadline: the lowest level whose reach covers the distance
+ * from the wheel's time. A past deadline goes into the current slot of level 0.
+ *
+ * @param node is the node
+ */
+void TimingWheel::place(int node)
+{
+    qint64 deadline = nodes[node].deadline;
+    qint64 distance = deadline - time;
+
+    if(distance < SLOTS){
+        link(node, (int)((distance > 0 ? deadline : time) & MASK));
+        return;
+    }
+
+    int level = 1;
+    while(level < LEVELS - 1 && (distance >> (SLOT_BITS * (level + 1))) != 0){
+        level++;
+    }
+
+    //Beyond the reach of the last level: wait in its farthest slot and be placed again from there
+    qint64 reach = (qint64)1 << (SLOT_BITS * LEVELS);
+    if(distance >= reach){
+        deadline = time + reach - 1;
+    }
+
+    link(node, level * SLOTS + (int)((deadline >> (SLOT_BITS * level)) & MASK));
+}
+
+/**
+ * Appends a node to a slot. A level 0 slot is marked unsorted if the node was added before its last one.
+ *
+ * @param node is the node
+ * @param slot is the slot (level * SLOTS + index)
+ */
+void TimingWheel::link(int node, int slot)
+{
+    Node& linked = nodes[node];
+    linked.slot = slot;
+    linked.next = NONE;
+    linked.prev = tails[slot];
+
+    if(tails[slot] == NONE){
+        heads[slot] = node;
+        occupied[slot >> SLOT_BITS] |= (quint64)1 << (slot & MASK);
+    }else{
+        nodes[tails[slot]].next = node;
+        if(slot < SLOTS && nodes[tails[slot]].id > linked.id){
+            unsorted |= (quint64)1 << slot;
+        }
+    }
+
+    tails[slot] = node;
+}
+
+/**
+ * Takes a node out of its slot
+ *
+ * @param node is the node
+ */
+void TimingWheel::unlink(int node)
+{
+    Node& unlinked = nodes[node];
+    int slot = unlinked.slot;
+
+    if(unlinked.prev != NONE){ nodes[unlinked.prev].next = unlinked.next; }else{ heads[slot] = unlinked.next; }
+    if(unlinked.next != NONE){ nodes[unlinked.next].prev = unlinked.prev; }else{ tails[slot] = unlinked.prev; }
+
+    if(heads[slot] == NONE){
+        quint64 bit = (quint64)1 << (slot & MASK);
+        occupied[slot >> SLOT_BITS] &= ~bit;
+        if(slot < SLOTS){ unsorted &= ~bit; }
+    }
+}
+
+/**
+ * Returns an unlinked node to the free list, dropping its callback
+ *
+ * @param node is the node
+ */
+void TimingWheel::release(int node)
+{
+    Node& released = nodes[node];
+    released.id = 0;
+    released.callback = nullptr;
+    released.next = freeNode;
+    freeNode = node;
+    count--;
+}
+
+/**
+ * Fires an event. Its node is freed before the callback is called, so the callback can add events.
+ *
+ * @param node is the node of the event
+ */
+void TimingWheel::fire(int node)
+{
+    unlink(node);
+    Callback callback = std::move(nodes[node].callback);
+    release(node);
+    cachedNext = -1;
+
+    callback();
+}
+
+/**
+ * First node of a level 0 slot in the order the events were added. Events that cascaded into the
+ * slot after others were added to it directly are put in order first.
+ *
+ * @param slot is the index of the slot
+ * @return the node, NONE if the slot is empty
+ */
+int TimingWheel::first(int slot)
+{
+    quint64 bit = (quint64)1 << slot;
+    if((unsorted & bit) == 0){ return heads[slot]; }
+
+    scratch.clear();
+    for(int node = heads[slot]; node != NONE; node = nodes[node].next){
+        scratch.push_back(node);
+    }
+    std::sort(scratch.begin(), scratch.end(), [this](int a, int b) { return nodes[a].id < nodes[b].id; });
+
+    heads[slot] = NONE;
+    tails[slot] = NONE;
+    for(int node : scratch){
+        link(node, slot);
+    }
+    unsorted &= ~bit;
+
+    return heads[slot];
+}
+
+/**
+ * Moves the events of a level's slot that starts at the wheel's time to the levels below
+ *
+ * @param level is the level, 1 or higher
+ */
+void TimingWheel::cascade(int level)
+{
+    int slot = level * SLOTS + (int)((time >> (SLOT_BITS * level)) & MASK);
+    int node = heads[slot];
+
+    heads[slot] = NONE;
+    tails[slot] = NONE;
+    occupied[level] &= ~((quint64)1 << (slot & MASK));
+
+    while(node != NONE){
+        int next = nodes[node].next;
+        place(node);
+        node = next;
+    }
+}
+
+/**
+ * Moves the time of the wheel to the next occupied slot of level 0 in the current 64 ms, or else to
+ * the start of the next occupied slot of any level, which is cascaded down. Empty slots are skipped.
+ *
+ * @param until is the time not to move past
+ * @return true if the time moved to a slot that may hold events due by until, false if it moved to until
+ */
+bool TimingWheel::step(qint64 until)
+{
+    int index = (int)(time & MASK);
+    quint64 later = index < MASK ? occupied[0] & (~(quint64)0 << (index + 1)) : 0;
+
+    if(later != 0){
+        qint64 next = (time & ~(qint64)MASK) + qCountTrailingZeroBits(later);
+        if(next > until){
+            time = until;
+            return false;
+        }
+
+        time = next;
+        return true;
+    }
+
+    //The earliest start of an occupied slot of any level after the current 64 ms
+    qint64 boundary = occupied[0] != 0 ? (time | MASK) + 1 : -1;
+    for(int level = 1; level < LEVELS; level++){
+        if(occupied[level] == 0){ continue; }
+
+        int shift = SLOT_BITS * level;
+        int offset = offsetAfter(occupied[level], (int)((time >> shift) & MASK));
+        qint64 start = ((time >> shift) + offset) << shift;
+        if(boundary < 0 || start < boundary){ boundary = start; }
+    }
+
+    if(boundary < 0 || boundary > until){
+        time = until;
+        return false;
+    }
+
+    //Every level whose slot starts here moves down, the highest first
+    time = boundary;
+    for(int level = LEVELS - 1; level > 0; level--){
+        if((boundary & (((qint64)1 << (SLOT_BITS * level)) - 1)) == 0){
+            cascade(level);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Earliest deadline of the events in a slot
+ *
+ * @param slot is the slot, not empty
+ * @return the deadline in ms
+ */
+qint64 TimingWheel::earliest(int slot)
+{
+    qint64 deadline = nodes[heads[slot]].deadline;
+    for(int node = nodes[heads[slot]].next; node != NONE; node = nodes[node].next){
+        if(nodes[node].deadline < deadline){ deadline = nodes[node].deadline; }
+    }
+    return deadline;
+}
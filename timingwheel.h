@@ -0,0 +1,86 @@
+#ifndef TIMINGWHEEL_H
+#define TIMINGWHEEL_H
+
+#include <functional>
+#include <vector>
+#include <QtGlobal>
+
+/*
+Class: TimingWheel
+
+Purpose: This class holds the pending deadlines of a Scheduler in a hierarchical timing wheel,
+         so arming and cancelling a deadline take the same time with 10 or 100k devices.
+
+Usage: - 6 levels of 64 slots: a slot of level 0 is 1 ms, a slot of the next level is 64 slots of
+         the level below (64 ms, 4 s, 4.5 min, ...). A deadline goes into the level its distance
+         from the wheel's time falls into, and moves down a level (cascades) when the wheel's time
+         reaches the start of its slot, until it is in a 1 ms slot of level 0
+       - add() links an event into its slot, remove() unlinks it: both O(1), events live in one
+         pool of nodes that is reused, the id finds the node
+       - fireUntil() moves the wheel's time forward and fires the events it passes. Empty
+         slots are skipped with a bit mask per level, so a jump of hours takes a few steps
+       - Events fire in deadline order, events with the same deadline in the order they were
+         added (ids grow with it). A deadline before the wheel's time fires at the wheel's time
+       - Up to 16M (2^24) events can be pending, add() returns 0 when full
+*/
+
+class TimingWheel
+{
+public:
+    typedef quint64 EventId;                        //Identifies an added event, 0 is never used
+    typedef std::function<void()> Callback;         //Called when an event's deadline is reached
+
+    TimingWheel();
+
+    EventId add(qint64 deadline, Callback callback);    //Add an event that fires at deadline (in ms), 0 if the wheel is full
+    bool remove(EventId id);                            //Remove a pending event, false if it already fired or was removed
+    void fireUntil(qint64 time);    //Fire every event with a deadline up to time, including the ones they add
+    bool fireFirst();               //Fire the next event only, false if nothing is pending
+
+    //Getters
+    bool isEmpty();                 //Whether no event is pending
+    qint64 getCount();              //Number of pending events
+    qint64 nextDeadline();          //Deadline of the next event, the wheel's time if it is past (only valid if !isEmpty())
+
+private:
+    static const int SLOT_BITS = 6;                 //64 slots per level
+    static const int SLOTS = 1 << SLOT_BITS;
+    static const int MASK = SLOTS - 1;
+    static const int LEVELS = 6;                    //Levels reach 2^36 ms (795 days) ahead, later deadlines wait in the last one
+    static const int INDEX_BITS = 24;               //Low bits of an id: the node, high bits: the order it was added in
+    static const int NONE = -1;
+
+    struct Node
+    {
+        qint64 deadline;            //When the event fires
+        EventId id;                 //Id of the event, 0 if the node is free
+        Callback callback;          //Called when it fires
+        int prev;                   //Previous node in the slot, NONE for the first
+        int next;                   //Next node in the slot (or in the free list), NONE for the last
+        int slot;                   //Slot it is linked into (level * SLOTS + index)
+    };
+
+    std::vector<Node> nodes;        //Pool of nodes, pending and free
+    int freeNode;                   //First free node, NONE if every node is used
+    int heads[LEVELS * SLOTS];      //First node of every slot, NONE if it is empty
+    int tails[LEVELS * SLOTS];      //Last node of every slot
+    quint64 occupied[LEVELS];       //Bit per slot of each level, set if it holds events
+    quint64 unsorted;               //Bit per slot of level 0, set if its events may not be in id order
+    qint64 time;                    //Time of the wheel: events before it have fired
+    quint64 sequence;               //Order of the next added event
+    qint64 count;                   //Number of pending events
+    qint64 cachedNext;              //Result of nextDeadline(), -1 if it has to be searched again
+    std::vector<int> scratch;       //Nodes of a slot while it is sorted
+
+    void place(int node);           //Link a node into the slot of its deadline
+    void link(int node, int slot);  //Append a node to a slot
+    void unlink(int node);          //Take a node out of its slot
+    void release(int node);         //Return a node to the free list
+    void fire(int node);            //Unlink a node, free it and call its callback
+    int first(int slot);            //First node of a level 0 slot in id order
+    void cascade(int level);        //Move the events of the current slot of a level down
+    bool step(qint64 until);        //Move the time to the next slot that may hold events, up to until
+    qint64 earliest(int slot);      //Earliest deadline in a slot
+};
+
+#endif // TIMINGWHEEL_H
@@ -0,0 +1,286 @@
+#include "trace.h"
+
+#include <QFile>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "spscring.h"
+
+/*
+Struct: TraceEvent
+
+Purpose: One event of the trace, as it waits in the ring of its thread.
+*/
+
+struct TraceEvent
+{
+    const char* name;       //Name of the event (string literal)
+    const char* category;   //Category of the event (string literal)
+    qint64 start;           //Time of the event in ns since tracing started
+    qint64 duration;        //Length of a span in ns
+    char phase;             //'X' for a span, 'i' for an instant
+};
+
+/*
+Struct: TraceBuffer
+
+Purpose: The events of one thread, between the thread (producer) and the writer (consumer).
+         Kept until the program ends, so a thread can always use the one it made.
+*/
+
+struct TraceBuffer
+{
+    SpscRing<TraceEvent, 8192> ring;        //Events not written yet
+    int tid;                                //Id of the thread in the trace
+    std::atomic<const char*> threadName;    //Name of the thread in the trace, may be nullptr
+    std::atomic<qint64> dropped;            //Events dropped because the ring was full
+};
+
+std::atomic<bool> Trace::enabled(false);
+
+//Every buffer ever made, guarded by bufferMutex
+static std::mutex bufferMutex;
+static std::vector<TraceBuffer*> buffers;
+
+//Buffer of the calling thread, nullptr until it records its first event
+static thread_local TraceBuffer* threadBuffer = nullptr;
+
+//The writer thread and the file it writes, only touched by start() and stop() besides the writer
+static std::thread writer;
+static std::mutex writerMutex;
+static std::condition_variable writerWake;
+static bool writerStopping = false;
+static QFile* file = nullptr;
+static bool firstEvent = true;
+
+//Time tracing started (ns of the steady clock), read by every recording thread
+static std::atomic<qint64> origin(0);
+
+
+/**
+ * Buffer of the calling thread, made and registered the first time.
+ * The ring keeps its indices on their own cache lines (alignas(64)), which plain new does not
+ * honour before C++17, so the buffer is placed in memory aligned by hand. It is never freed.
+ *
+ * @return the buffer of the thread
+ */
+static TraceBuffer* currentBuffer()
+{
+    if(threadBuffer == nullptr){
+        const std::size_t align = alignof(TraceBuffer);
+        std::uintptr_t memory = (std::uintptr_t)::operator new(sizeof(TraceBuffer) + align - 1);
+        TraceBuffer* buffer = new((void*)((memory + align - 1) & ~(std::uintptr_t)(align - 1))) TraceBuffer();
+        buffer->threadName = nullptr;
+        buffer->dropped = 0;
+
+        std::lock_guard<std::mutex> lock(bufferMutex);
+        buffer->tid = (int)buffers.size() + 1;
+        buffers.push_back(buffer);
+        threadBuffer = buffer;
+    }
+
+    return threadBuffer;
+}
+
+/**
+ * Appends an event to the text of the trace
+ *
+ * @param text receives the event as a JSON object, after a comma unless it is the first one
+ * @param event is the event
+ * @param tid is the id of the thread that recorded it
+ */
+static void appendEvent(std::string& text, const TraceEvent& event, int tid)
+{
+    char line[256];
+
+    if(event.phase == 'X'){
+        snprintf(line, sizeof(line), "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                 firstEvent ? "\n" : ",\n", event.name, event.category, tid, event.start / 1000.0, event.duration / 1000.0);
+    }else{
+        snprintf(line, sizeof(line), "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%d,\"ts\":%.3f}",
+                 firstEvent ? "\n" : ",\n", event.name, event.category, tid, event.start / 1000.0);
+    }
+
+    text += line;
+    firstEvent = false;
+}
+
+/**
+ * Moves the events of every thread's ring to the file. Writer thread only (or start()/stop()
+ * while the writer is not running).
+ *
+ * @param keep is false to throw the events away instead of writing them
+ */
+static void drain(bool keep)
+{
+    std::vector<TraceBuffer*> current;
+    {
+        std::lock_guard<std::mutex> lock(bufferMutex);
+        current = buffers;
+    }
+
+    std::string text;
+    TraceEvent event;
+    for(TraceBuffer* buffer : current){
+        while(buffer->ring.tryPop(event)){
+            if(keep){ appendEvent(text, event, buffer->tid); }
+        }
+    }
+
+    if(!text.empty()){
+        file->write(text.data(), (qint64)text.size());
+    }
+}
+
+/**
+ * Runs on the writer thread, drains the rings every 100ms until tracing stops
+ */
+static void writeLoop()
+{
+    std::unique_lock<std::mutex> lock(writerMutex);
+    while(!writerStopping){
+        writerWake.wait_for(lock, std::chrono::milliseconds(100));
+
+        lock.unlock();
+        drain(true);
+        lock.lock();
+    }
+}
+
+
+/**
+ * Starts tracing into a new file, replacing it. Events left from an earlier trace are dropped.
+ *
+ * @param path is the file to write the trace to
+ * @return false if tracing already runs or the file could not be made
+ */
+bool Trace::start(const QString& path)
+{
+    if(file != nullptr){ return false; }
+
+    file = new QFile(path);
+    if(!file->open(QIODevice::WriteOnly | QIODevice::Truncate)){
+        delete file;
+        file = nullptr;
+        return false;
+    }
+
+    drain(false);
+    {
+        std::lock_guard<std::mutex> lock(bufferMutex);
+        for(TraceBuffer* buffer : buffers){ buffer->dropped = 0; }
+    }
+
+    const char* header = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    file->write(header, (qint64)strlen(header));
+    firstEvent = true;
+
+    origin.store(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     std::chrono::steady_clock::now().time_since_epoch()).count(), std::memory_order_relaxed);
+    writerStopping = false;
+    writer = std::thread(writeLoop);
+
+    //Threads that see tracing on also see everything set up above
+    enabled.store(true, std::memory_order_release);
+    return true;
+}
+
+/**
+ * Stops tracing: waits for the writer to write every event recorded so far, then ends the file
+ * with the names of the threads and the number of events each dropped
+ */
+void Trace::stop()
+{
+    if(file == nullptr){ return; }
+
+    enabled.store(false, std::memory_order_release);
+
+    {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        writerStopping = true;
+    }
+    writerWake.notify_one();
+    writer.join();
+    drain(true);
+
+    //Thread names and dropped events as metadata
+    std::string text;
+    char line[256];
+    {
+        std::lock_guard<std::mutex> lock(bufferMutex);
+        for(TraceBuffer* buffer : buffers){
+            const char* name = buffer->threadName.load();
+            if(name != nullptr){
+                snprintf(line, sizeof(line), "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                         firstEvent ? "\n" : ",\n", buffer->tid, name);
+                text += line;
+                firstEvent = false;
+            }
+            if(buffer->dropped > 0){
+                snprintf(line, sizeof(line), "%s{\"name\":\"dropped events\",\"ph\":\"C\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"args\":{\"dropped\":%lld}}",
+                         firstEvent ? "\n" : ",\n", buffer->tid, now() / 1000.0, (long long)buffer->dropped.load());
+                text += line;
+                firstEvent = false;
+            }
+        }
+    }
+    text += "\n]}\n";
+    file->write(text.data(), (qint64)text.size());
+
+    file->close();
+    delete file;
+    file = nullptr;
+}
+
+/**
+ * Names the calling thread in the trace
+ * @param name is a string literal
+ */
+void Trace::setThreadName(const char* name)
+{
+    currentBuffer()->threadName = name;
+}
+
+/**
+ * Time since tracing started
+ * @return the time in ns
+ */
+qint64 Trace::now()
+{
+    qint64 clock = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    return clock - origin.load(std::memory_order_relaxed);
+}
+
+/**
+ * Records an event into the ring of the calling thread, never blocks.
+ * Drops the event if the ring is full (the writer is more than a ring behind).
+ *
+ * @param name is the name of the event (string literal)
+ * @param category is the category of the event (string literal)
+ * @param phase is 'X' for a span, 'i' for an instant
+ * @param start is the time of the event in ns
+ * @param duration is the length of a span in ns
+ */
+void Trace::record(const char* name, const char* category, char phase, qint64 start, qint64 duration)
+{
+    TraceBuffer* buffer = currentBuffer();
+
+    TraceEvent event;
+    event.name = name;
+    event.category = category;
+    event.start = start;
+    event.duration = duration;
+    event.phase = phase;
+
+    if(!buffer->ring.tryPush(event)){
+        buffer->dropped++;
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+
+/*
+Class: Trace
+
+Purpose: Records what the device does, and when, as a Chrome trace (chrome://tracing, Perfetto).
+
+Usage: Trace::start(path) starts writing the trace to path, Trace::stop() finishes the file.
+       Events are either spans (a TraceScope around a slot, a timer callback, a device input) or
+       instants (Trace::instant(), a change of state such as "treating"):
+        - each thread records into its own lock-free ring (SpscRing), made the first time the
+          thread records something while tracing, so recording never locks or allocates
+        - a writer thread drains the rings every 100ms and appends the events to the file
+        - names and categories are string literals, only their pointers are recorded
+        - a full ring drops the event and counts it, the count is written at the end of the trace
+       While tracing is off, a TraceScope or instant() only reads one atomic flag.
+*/
+
+class Trace
+{
+public:
+    static bool start(const QString& path);         //Start tracing into a new file, false if it could not be made
+    static void stop();                             //Stop tracing and finish the file (does nothing if not tracing)
+    static void setThreadName(const char* name);    //Name the calling thread in the trace
+
+    //Whether events are recorded
+    static bool isEnabled() { return enabled.load(std::memory_order_acquire); }
+
+    //Record an instant event, e.g. a change of state
+    static void instant(const char* name, const char* category = "state")
+    {
+        if(isEnabled()){ record(name, category, 'i', now(), 0); }
+    }
+
+    static qint64 now();                            //Time since tracing started in ns
+    static void record(const char* name, const char* category, char phase, qint64 start, qint64 duration);  //Record an event on the calling thread
+
+private:
+    static std::atomic<bool> enabled;               //Whether tracing is on
+};
+
+
+/*
+Class: TraceScope
+
+Purpose: Records a block of code as a span of the trace
+
+Usage: Make one at the start of the block with a string literal name, the span ends when it goes
+       out of scope. Records nothing while tracing is off.
+*/
+
+class TraceScope
+{
+public:
+    TraceScope(const char* name, const char* category = "device")
+        : name(Trace::isEnabled() ? name : nullptr), category(category), start(0)
+    {
+        if(this->name != nullptr){ start = Trace::now(); }
+    }
+
+    ~TraceScope()
+    {
+        if(name != nullptr){ Trace::record(name, category, 'X', start, Trace::now() - start); }
+    }
+
+private:
+    const char* name;           //Name of the span, nullptr while tracing is off
+    const char* category;       //Category of the span
+    qint64 start;               //Start of the span in ns
+};
+
+#endif // TRACE_H
@@ -0,0 +1,272 @@
+#include "usagerollups.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <cstring>
+#include <vector>
+
+/**
+ * Magic bytes at the start of every rollup file
+ */
+static const char MAGIC[8] = { 'C', 'E', 'S', 'R', 'O', 'L', 'v', '1' };
+
+/**
+ * One period of a rollup file: kind (0 - day, 1 - week), julian day, then the totals
+ */
+struct StoredRollup
+{
+    qint64 kind;
+    qint64 julianDay;
+    UsageTotals combinations[9];
+};
+
+
+/**
+ * Get the time weighted average power level of the sessions
+ * @return the average power level (0 - 10), 0 if no minutes were treated
+ */
+double UsageTotals::averagePowerLevel() const
+{
+    return minutes > 0 ? (double)powerMinutes / minutes : 0.0;
+}
+
+/**
+ * Adds the totals of other sessions to these totals
+ * @param other is the totals to add
+ */
+void UsageTotals::add(const UsageTotals& other)
+{
+    sessions += other.sessions;
+    minutes += other.minutes;
+    powerMinutes += other.powerMinutes;
+}
+
+
+/**
+ * Constructor for the UsageRollups. Starts empty, nothing is loaded yet.
+ *
+ * @param path is the path of the sidecar file
+ */
+UsageRollups::UsageRollups(const QString& path) : path(path)
+{
+    this->recordCount = 0;
+}
+
+/**
+ * Deconstructor for the UsageRollups
+ */
+UsageRollups::~UsageRollups()
+{
+
+}
+
+/**
+ * Loads the rollups saved in the sidecar file, then counts the records of the store
+ * that were added after the last save. Rollups that don't belong to the store (more records
+ * than the store has, unreadable file) are rebuilt from the store.
+ *
+ * @param store is the record store the rollups are kept for
+ * @return false if the sidecar file was unusable and the rollups were rebuilt
+ */
+bool UsageRollups::open(RecordStore* store)
+{
+    byDay.clear();
+    byWeek.clear();
+    recordCount = 0;
+
+    bool loaded = false;
+    QFile file(path);
+
+    if(file.open(QIODevice::ReadOnly)){
+        char magic[8];
+        qint64 count = 0, periods = 0;
+
+        if(file.read(magic, 8) == 8 && memcmp(magic, MAGIC, 8) == 0
+                && file.read((char*)&count, 8) == 8 && file.read((char*)&periods, 8) == 8
+                && count <= store->count() && periods >= 0){
+
+            std::vector<StoredRollup> stored(periods);
+            qint64 bytes = periods * (qint64)sizeof(StoredRollup);
+            if(periods == 0 || file.read((char*)stored.data(), bytes) == bytes){
+                for(const StoredRollup& period : stored){
+                    Rollup& rollup = period.kind == 0 ? byDay[period.julianDay] : byWeek[period.julianDay];
+                    memcpy(rollup.combinations, period.combinations, sizeof(rollup.combinations));
+                }
+                recordCount = count;
+                loaded = true;
+            }
+        }
+        file.close();
+    }
+
+    if(!loaded){
+        byDay.clear();
+        byWeek.clear();
+    }
+
+    //Count the records added since the last save
+    while(recordCount < store->count()){
+        add(store->at(recordCount));
+    }
+
+    return loaded;
+}
+
+/**
+ * Writes every period of the rollups to the sidecar file
+ *
+ * @return false if the file could not be written
+ */
+bool UsageRollups::save()
+{
+    std::vector<StoredRollup> stored;
+    stored.reserve(byDay.size() + byWeek.size());
+
+    for(int kind = 0; kind < 2; kind++){
+        const std::unordered_map<qint64, Rollup>& periods = kind == 0 ? byDay : byWeek;
+        for(const std::pair<const qint64, Rollup>& period : periods){
+            StoredRollup entry;
+            entry.kind = kind;
+            entry.julianDay = period.first;
+            memcpy(entry.combinations, period.second.combinations, sizeof(entry.combinations));
+            stored.push_back(entry);
+        }
+    }
+
+    QFile file(path);
+    if(!file.open(QIODevice::WriteOnly)){
+        return false;
+    }
+
+    qint64 periods = (qint64)stored.size();
+    qint64 bytes = periods * (qint64)sizeof(StoredRollup);
+    bool written = file.write(MAGIC, 8) == 8
+            && file.write((const char*)&recordCount, 8) == 8
+            && file.write((const char*)&periods, 8) == 8
+            && (periods == 0 || file.write((const char*)stored.data(), bytes) == bytes);
+
+    file.close();
+    return written;
+}
+
+/**
+ * Counts a new recorded session in its day and its week. O(1): only those two periods change.
+ *
+ * @param record is the recorded session
+ */
+void UsageRollups::add(const SessionRecord& record)
+{
+    recordCount++;
+
+    if(record.waveform > 2 || record.frequency > 2){ return; }
+
+    int combination = record.waveform * 3 + record.frequency;
+    qint64 julianDay = dayOf(record.startTime);
+
+    UsageTotals* totals[2] = { &byDay[julianDay].combinations[combination],
+                               &byWeek[weekOf(julianDay)].combinations[combination] };
+
+    for(UsageTotals* period : totals){
+        period->sessions++;
+        period->minutes += record.duration;
+        period->powerMinutes += (quint64)record.powerLevel * record.duration;
+    }
+}
+
+/**
+ * Totals of one period, for the matching waveform/frequency combinations
+ *
+ * @param periods is the day or week rollups
+ * @param key is the julian day of the period
+ * @param waveform is 0 - 2, -1 for any
+ * @param frequency is 0 - 2, -1 for any
+ * @return the totals
+ */
+UsageTotals UsageRollups::select(const std::unordered_map<qint64, Rollup>& periods, qint64 key, int waveform, int frequency)
+{
+    UsageTotals totals;
+    memset(&totals, 0, sizeof(totals));
+
+    std::unordered_map<qint64, Rollup>::const_iterator period = periods.find(key);
+    if(period == periods.end()){ return totals; }
+
+    for(int w = 0; w < 3; w++){
+        for(int f = 0; f < 3; f++){
+            if((waveform < 0 || waveform == w) && (frequency < 0 || frequency == f)){
+                totals.add(period->second.combinations[w * 3 + f]);
+            }
+        }
+    }
+
+    return totals;
+}
+
+/**
+ * Get the totals of a local day
+ * @param julianDay is the day
+ * @param waveform is 0 - 2, -1 for any
+ * @param frequency is 0 - 2, -1 for any
+ * @return the totals of the sessions started that day
+ */
+UsageTotals UsageRollups::day(qint64 julianDay, int waveform, int frequency)
+{
+    return select(byDay, julianDay, waveform, frequency);
+}
+
+/**
+ * Get the totals of the ISO week (Monday to Sunday) holding a day
+ * @param julianDay is any day of the week
+ * @param waveform is 0 - 2, -1 for any
+ * @param frequency is 0 - 2, -1 for any
+ * @return the totals of the sessions started that week
+ */
+UsageTotals UsageRollups::week(qint64 julianDay, int waveform, int frequency)
+{
+    return select(byWeek, weekOf(julianDay), waveform, frequency);
+}
+
+/**
+ * Get the totals of a range of days. Costs one lookup per day, whatever the number of records.
+ * @param firstDay is the first day of the range
+ * @param lastDay is the last day of the range (included)
+ * @param waveform is 0 - 2, -1 for any
+ * @param frequency is 0 - 2, -1 for any
+ * @return the totals of the sessions started in the range
+ */
+UsageTotals UsageRollups::days(qint64 firstDay, qint64 lastDay, int waveform, int frequency)
+{
+    UsageTotals totals;
+    memset(&totals, 0, sizeof(totals));
+
+    for(qint64 julianDay = firstDay; julianDay <= lastDay; julianDay++){
+        totals.add(day(julianDay, waveform, frequency));
+    }
+
+    return totals;
+}
+
+/**
+ * Get the number of records counted in the rollups
+ * @return the number of records
+ */
+qint64 UsageRollups::getRecordCount(){ return recordCount; }
+
+/**
+ * Get the local day a session started on
+ * @param startTime is the start time (seconds since the epoch)
+ * @return the julian day
+ */
+qint64 UsageRollups::dayOf(qint64 startTime)
+{
+    return QDateTime::fromSecsSinceEpoch(startTime).date().toJulianDay();
+}
+
+/**
+ * Get the first day (Monday) of the ISO week holding a day
+ * @param julianDay is the day
+ * @return the julian day of the Monday
+ */
+qint64 UsageRollups::weekOf(qint64 julianDay)
+{
+    return julianDay - (QDate::fromJulianDay(julianDay).dayOfWeek() - 1);
+}
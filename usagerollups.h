@@ -0,0 +1,76 @@
+#ifndef USAGEROLLUPS_H
+#define USAGEROLLUPS_H
+
+#include <QString>
+#include <QtGlobal>
+#include <unordered_map>
+
+#include "recordstore.h"
+#include "sessionrecord.h"
+
+/*
+Struct: UsageTotals
+
+Purpose: Usage totals of a set of recorded sessions.
+*/
+
+struct UsageTotals
+{
+    quint32 sessions;           //Number of sessions
+    quint32 minutes;            //Minutes treated
+    quint64 powerMinutes;       //Power level times minutes, summed over the sessions
+
+    double averagePowerLevel() const;       //Time weighted average power level (0 - 10), 0 without any minutes
+    void add(const UsageTotals& other);     //Add the totals of other sessions
+};
+
+
+/*
+Class: UsageRollups
+
+Purpose: This class keeps per-day and per-week usage totals of the recorded sessions up to date.
+
+Usage: Totals are kept for each local day and each ISO week (starting on Monday), split by
+       waveform/frequency combination: session count, minutes treated and power level minutes
+       (for the time weighted average power). add() updates one day and one week in O(1) when a
+       session is recorded, dashboard queries read the totals and never touch the records.
+       The rollups are saved next to the record log (a sidecar file) and loaded at startup;
+       records added to the log after the last save are caught up from the RecordStore.
+*/
+
+class UsageRollups
+{
+public:
+    UsageRollups(const QString& path);
+    ~UsageRollups();
+
+    bool open(RecordStore* store);          //Load the saved rollups and catch up with the store
+    bool save();                            //Write the rollups to the sidecar file
+    void add(const SessionRecord& record);  //Count a new recorded session
+
+    //Dashboard queries, waveform/frequency -1 for any
+    UsageTotals day(qint64 julianDay, int waveform = -1, int frequency = -1);      //Totals of a local day
+    UsageTotals week(qint64 julianDay, int waveform = -1, int frequency = -1);     //Totals of the ISO week holding a day
+    UsageTotals days(qint64 firstDay, qint64 lastDay, int waveform = -1, int frequency = -1);   //Totals of a range of days
+
+    //Getters
+    qint64 getRecordCount();                //Number of records counted in the rollups
+    static qint64 dayOf(qint64 startTime);  //Local julian day of a start time
+    static qint64 weekOf(qint64 julianDay); //Julian day of the Monday of the week holding a day
+
+private:
+    //Totals of one period for each waveform * 3 + frequency
+    struct Rollup
+    {
+        UsageTotals combinations[9];
+    };
+
+    QString path;                                   //Path of the sidecar file
+    qint64 recordCount;                             //Records counted so far
+    std::unordered_map<qint64, Rollup> byDay;       //Totals of each local day (julian day)
+    std::unordered_map<qint64, Rollup> byWeek;      //Totals of each week (julian day of its Monday)
+
+    UsageTotals select(const std::unordered_map<qint64, Rollup>& periods, qint64 key, int waveform, int frequency);
+};
+
+#endif // USAGEROLLUPS_H
@@ -0,0 +1,141 @@
+#include "waveformgenerator.h"
+#include "therapysession.h"
+
+#include "waveformkernels.h"
+
+//Samples generated from one starting phase, keeps the rounding of the 32 bit phase step of a lane negligible
+static const int BLOCK_SIZE = 4096;
+
+
+/**
+ * Output of an unknown waveform or frequency selection: no current
+ *
+ * @param samples receives count zero samples
+ */
+static void silentKernel(float* samples, int count, quint32, quint32, float)
+{
+    for(int i = 0; i < count; i++){
+        samples[i] = 0.0f;
+    }
+}
+
+
+/**
+ * Constructor for the WaveformGenerator. Starts as an Alpha wave at 0.5Hz and 100uA,
+ * the default settings of a therapy session.
+ *
+ * @param sampleRate is the number of samples per second, raised to MIN_SAMPLE_RATE if it is lower
+ */
+WaveformGenerator::WaveformGenerator(int sampleRate)
+{
+    this->sampleRate = sampleRate < WaveformKernels::MIN_SAMPLE_RATE ? WaveformKernels::MIN_SAMPLE_RATE : sampleRate;
+    this->phase = 0;
+    configure(0, 0, 2);
+}
+
+
+/**
+ * Deconstructor for the WaveformGenerator
+ */
+WaveformGenerator::~WaveformGenerator()
+{
+
+}
+
+
+/**
+ * Sets the signal to generate and picks its specialized generator, the only place the
+ * waveform and frequency are looked at. The phase is kept so a change of settings does not
+ * make the signal jump in time.
+ *
+ * @param waveform is 0 - Alpha, 1 - Beta, 2 - Gamma
+ * @param frequency is 0 - 0.5Hz, 1 - 77Hz, 2 - 100Hz
+ * @param powerLevel is the power level, 0 - 10 (50uA per level)
+ */
+void WaveformGenerator::configure(int waveform, int frequency, int powerLevel)
+{
+    this->amplitude = amplitudeMicroAmps(powerLevel);
+
+    if(waveform < 0 || waveform > 2 || frequency < 0 || frequency > 2){
+        //Shouldn't happen, no output
+        this->kernel = silentKernel;
+        this->phaseIncrement = 0;
+        return;
+    }
+
+    //The specialized generators are built for one sample rate
+    if(sampleRate == WaveformKernels::SPECIALIZED_RATE){
+        this->kernel = WaveformKernels::KERNELS[waveform][frequency];
+    }else{
+        this->kernel = WaveformKernels::GENERIC_KERNELS[waveform];
+    }
+    this->phaseIncrement = WaveformKernels::phaseIncrement(frequency, sampleRate);
+}
+
+
+/**
+ * Sets the signal to the current settings of a therapy session
+ *
+ * @param session is the therapy session to take the waveform, frequency and power level from
+ */
+void WaveformGenerator::configure(TherapySession* session)
+{
+    configure(session->getWaveform(), session->getFrequency(), session->getLastPowerLevel());
+}
+
+
+/**
+ * Writes the next count samples of the signal
+ *
+ * @param samples receives count current samples in uA
+ * @param count is the number of samples to write
+ */
+void WaveformGenerator::generate(float* samples, int count)
+{
+    //Step of the 32 bit phase of the lanes, rounded to nearest (as WaveformKernels::laneIncrement())
+    quint32 laneIncrement = (quint32)((phaseIncrement + 0x80000000ull) >> 32);
+
+    for(int start = 0; start < count; start += BLOCK_SIZE){
+        int blockSize = count - start < BLOCK_SIZE ? count - start : BLOCK_SIZE;
+
+        kernel(samples + start, blockSize, (quint32)(phase >> 32), laneIncrement, amplitude);
+
+        //The 64 bit phase wraps around at the end of a period on its own
+        phase += (quint64)blockSize * phaseIncrement;
+    }
+}
+
+
+/**
+ * Restarts the signal at the beginning of a period
+ */
+void WaveformGenerator::reset(){ phase = 0; }
+
+/**
+ * Get the number of samples per second
+ * @return the sample rate
+ */
+int WaveformGenerator::getSampleRate(){ return sampleRate; }
+
+/**
+ * Get the position in the current period of the next sample
+ * @return the phase, 0 - 1
+ */
+double WaveformGenerator::getPhase(){ return phase / WaveformKernels::FULL_PERIOD; }
+
+/**
+ * Frequency of a frequency selection
+ * @param frequency is 0 - 0.5Hz, 1 - 77Hz, 2 - 100Hz
+ * @return the frequency in Hz, 0 for an unknown selection
+ */
+double WaveformGenerator::frequencyHz(int frequency)
+{
+    return frequency >= 0 && frequency <= 2 ? WaveformKernels::FREQUENCY_HZ[frequency] : 0.0;
+}
+
+/**
+ * Peak current of a power level
+ * @param powerLevel is 0 - 10
+ * @return the current in uA (50uA per level)
+ */
+float WaveformGenerator::amplitudeMicroAmps(int powerLevel){ return powerLevel * 50.0f; }
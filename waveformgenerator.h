@@ -0,0 +1,51 @@
+#ifndef WAVEFORMGENERATOR_H
+#define WAVEFORMGENERATOR_H
+
+#include <QtGlobal>
+#include "waveformkernels.h"
+
+class TherapySession;
+
+/*
+Class: WaveformGenerator
+
+Purpose: This class produces the output current of the CES device as a stream of samples.
+
+Usage: Turns the settings of a therapy session into current samples (in uA) at a configurable sample rate
+       (at least MIN_SAMPLE_RATE, 200 per second, a lower one is raised to it):
+        - waveform: 0 - Alpha (biphasic square), 1 - Beta (sine), 2 - Gamma (triangle)
+        - frequency: 0 - 0.5Hz, 1 - 77Hz, 2 - 100Hz
+        - amplitude: the power level, 0 - 10 (50uA per level, 0 - 500uA)
+       The phase carries over from one generate() call to the next, so consecutive blocks form
+       one continuous signal. configure() picks the generator specialized for the waveform and
+       frequency (see waveformkernels.h) once, or the generic one of the waveform at a sample rate other
+       than 48000. generate() then runs it without looking at the settings.
+       The inner loops use SSE2 on x86 (4 samples per instruction) and plain loops elsewhere.
+*/
+
+class WaveformGenerator
+{
+public:
+    WaveformGenerator(int sampleRate = 48000);
+    ~WaveformGenerator();
+
+    void configure(int waveform, int frequency, int powerLevel);    //Set the waveform, frequency (0 - 2) and power level (0 - 10)
+    void configure(TherapySession* session);                        //Take the waveform, frequency and power level of a session
+    void generate(float* samples, int count);                       //Write the next count samples (in uA)
+    void reset();                                                   //Restart the signal at phase 0
+
+    //Getters
+    int getSampleRate();            //Samples per second
+    double getPhase();              //Position in the current period, 0 - 1
+    static double frequencyHz(int frequency);       //Frequency in Hz of a frequency selection (0 - 2)
+    static float amplitudeMicroAmps(int powerLevel); //Peak current in uA of a power level (0 - 10)
+
+private:
+    int sampleRate;                 //Samples per second
+    WaveformKernels::Kernel kernel; //Generator of the selected waveform and frequency
+    quint64 phase;                  //Position in the current period at the next sample (fixed point, 2^64 is a full period)
+    quint64 phaseIncrement;         //Part of a period between two samples (same fixed point)
+    float amplitude;                //Peak current in uA
+};
+
+#endif // WAVEFORMGENERATOR_H
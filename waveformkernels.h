@@ -0,0 +1,194 @@
+#ifndef WAVEFORMKERNELS_H
+#define WAVEFORMKERNELS_H
+
+#include <QtGlobal>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*
+Namespace: WaveformKernels
+
+Purpose: Sample generators of the CES device output, one per waveform/frequency combination.
+
+Usage: The device only has 3 waveforms (0 - Alpha square, 1 - Beta sine, 2 - Gamma triangle) and
+       3 frequencies (0 - 0.5Hz, 1 - 77Hz, 2 - 100Hz), so every one of the 9 combinations is its own
+       template instance SpecializedGenerator<waveform, frequency>:
+        - the phase increment of its frequency at SPECIALIZED_RATE (48000 samples per second, the rate
+          of the output thread) comes from constexpr tables and is a constant of its code
+        - the phase is a 32 bit fixed point fraction of a period that wraps around on its own,
+          so the inner loop has no branch, no division and no floor
+       KERNELS[waveform][frequency] picks the instance once, when a session starts. Other sample rates
+       use GENERIC_KERNELS[waveform], the same code with the increment given when it is called.
+*/
+
+namespace WaveformKernels
+{
+
+//Frequency of each frequency selection in Hz
+constexpr double FREQUENCY_HZ[3] = { 0.5, 77.0, 100.0 };
+
+//Period of each frequency selection in seconds
+constexpr double PERIOD_SECONDS[3] = { 1.0 / 0.5, 1.0 / 77.0, 1.0 / 100.0 };
+
+//A full period in 64 bit fixed point phase (2^64, the phase wraps around at it)
+constexpr double FULL_PERIOD = 18446744073709551616.0;
+
+//A full period in the 32 bit fixed point phase used by the inner loops (2^32)
+constexpr float LANE_PERIOD = 4294967296.0f;
+
+//Lowest sample rate, twice the highest frequency: every period has at least 2 samples,
+//and the phase step stays below a full period
+constexpr int MIN_SAMPLE_RATE = 200;
+
+//Fixed point phase step between two samples of each frequency selection at a sample rate,
+//0 (no signal) below MIN_SAMPLE_RATE
+constexpr quint64 phaseIncrement(int frequency, int sampleRate)
+{
+    return sampleRate < MIN_SAMPLE_RATE ? 0 : (quint64)(FULL_PERIOD / (PERIOD_SECONDS[frequency] * sampleRate));
+}
+
+//Sample rate the specialized generators are built for, the default of WaveformGenerator and OutputThread
+constexpr int SPECIALIZED_RATE = 48000;
+
+//Step of the 32 bit phase of the lanes, rounded to nearest
+constexpr quint32 laneIncrement(int frequency, int sampleRate)
+{
+    return (quint32)((phaseIncrement(frequency, sampleRate) + 0x80000000ull) >> 32);
+}
+
+//Frequency of the generic generators: any, the increment is given when they are called
+constexpr int ANY_FREQUENCY = -1;
+
+//Writes count samples starting at the 32 bit phase, increment is the 32 bit phase step
+typedef void (*Kernel)(float* samples, int count, quint32 phase, quint32 increment, float amplitude);
+
+
+/*
+ * Shape of a waveform at a 32 bit phase, scalar and 4 lanes at a time.
+ * Specialized below for each waveform.
+ */
+template<int W> struct Shape;
+
+//Alpha: biphasic square, the top bit of the phase is the sign of the current
+template<> struct Shape<0>
+{
+    static float sample(quint32 phase, float amplitude)
+    {
+        return (phase & 0x80000000u) ? -amplitude : amplitude;
+    }
+
+#ifdef __SSE2__
+    static __m128 samples(__m128i phase, __m128 amplitude)
+    {
+        return _mm_xor_ps(amplitude, _mm_castsi128_ps(_mm_and_si128(phase, _mm_set1_epi32((int)0x80000000u))));
+    }
+#endif
+};
+
+//Beta: sine, corrected parabola of t = 2p - 1 (error about 0.1% of the amplitude)
+template<> struct Shape<1>
+{
+    static float sample(quint32 phase, float amplitude)
+    {
+        float t = (float)(qint32)(phase ^ 0x80000000u) * (2.0f / LANE_PERIOD);
+        float y = 4.0f * (t - t * (t < 0 ? -t : t));
+        y += 0.225f * (y * (y < 0 ? -y : y) - y);
+        return -y * amplitude;
+    }
+
+#ifdef __SSE2__
+    static __m128 samples(__m128i phase, __m128 amplitude)
+    {
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+        __m128i centered = _mm_xor_si128(phase, _mm_set1_epi32((int)0x80000000u));
+        __m128 t = _mm_mul_ps(_mm_cvtepi32_ps(centered), _mm_set1_ps(2.0f / LANE_PERIOD));
+        __m128 y = _mm_mul_ps(_mm_set1_ps(4.0f), _mm_sub_ps(t, _mm_mul_ps(t, _mm_and_ps(t, absMask))));
+        y = _mm_add_ps(y, _mm_mul_ps(_mm_set1_ps(0.225f), _mm_sub_ps(_mm_mul_ps(y, _mm_and_ps(y, absMask)), y)));
+        return _mm_mul_ps(_mm_sub_ps(_mm_setzero_ps(), y), amplitude);
+    }
+#endif
+};
+
+//Gamma: triangle, amplitude * (1 - 4|p - 0.5|)
+template<> struct Shape<2>
+{
+    static float sample(quint32 phase, float amplitude)
+    {
+        float distance = (float)(qint32)(phase ^ 0x80000000u);
+        distance = distance < 0 ? -distance : distance;
+        return amplitude - distance * (4.0f * amplitude / LANE_PERIOD);
+    }
+
+#ifdef __SSE2__
+    static __m128 samples(__m128i phase, __m128 amplitude)
+    {
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+        __m128i centered = _mm_xor_si128(phase, _mm_set1_epi32((int)0x80000000u));
+        __m128 distance = _mm_and_ps(_mm_cvtepi32_ps(centered), absMask);
+        __m128 slope = _mm_mul_ps(amplitude, _mm_set1_ps(4.0f / LANE_PERIOD));
+        return _mm_sub_ps(amplitude, _mm_mul_ps(distance, slope));
+    }
+#endif
+};
+
+
+/*
+ * Generator of one waveform/frequency combination at SPECIALIZED_RATE,
+ * or of one waveform at any frequency and rate for F = ANY_FREQUENCY
+ */
+template<int W, int F>
+struct SpecializedGenerator
+{
+    //Phase step of the lanes, a constant unless F is ANY_FREQUENCY
+    static quint32 step(quint32 increment)
+    {
+        return F == ANY_FREQUENCY ? increment : laneIncrement(F == ANY_FREQUENCY ? 0 : F, SPECIALIZED_RATE);
+    }
+
+    //Writes count samples, the phase of lane i is phase + i * increment (wrapping around).
+    //A specialized generator ignores increment, its own is the same at SPECIALIZED_RATE
+    static void generate(float* samples, int count, quint32 phase, quint32 increment, float amplitude)
+    {
+        int i = 0;
+        increment = step(increment);
+
+#ifdef __SSE2__
+        __m128i lanes = _mm_add_epi32(_mm_set1_epi32((int)phase),
+                                      _mm_set_epi32((int)(3 * increment), (int)(2 * increment), (int)increment, 0));
+        const __m128i step = _mm_set1_epi32((int)(4 * increment));
+        const __m128 peak = _mm_set1_ps(amplitude);
+
+        for(; i + 4 <= count; i += 4){
+            _mm_storeu_ps(samples + i, Shape<W>::samples(lanes, peak));
+            lanes = _mm_add_epi32(lanes, step);
+        }
+#endif
+
+        for(; i < count; i++){
+            samples[i] = Shape<W>::sample(phase + (quint32)i * increment, amplitude);
+        }
+    }
+};
+
+
+//The generator of every combination, indexed [waveform][frequency]
+constexpr Kernel KERNELS[3][3] = {
+    { SpecializedGenerator<0, 0>::generate, SpecializedGenerator<0, 1>::generate, SpecializedGenerator<0, 2>::generate },
+    { SpecializedGenerator<1, 0>::generate, SpecializedGenerator<1, 1>::generate, SpecializedGenerator<1, 2>::generate },
+    { SpecializedGenerator<2, 0>::generate, SpecializedGenerator<2, 1>::generate, SpecializedGenerator<2, 2>::generate }
+};
+
+//The generator of every waveform at any sample rate, indexed [waveform]
+constexpr Kernel GENERIC_KERNELS[3] = {
+    SpecializedGenerator<0, ANY_FREQUENCY>::generate,
+    SpecializedGenerator<1, ANY_FREQUENCY>::generate,
+    SpecializedGenerator<2, ANY_FREQUENCY>::generate
+};
+
+}
+
+#endif // WAVEFORMKERNELS_H